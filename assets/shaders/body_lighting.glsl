@@ -0,0 +1,139 @@
+// Lighting shared by planet.fs and impostor.fs: clustered lights, eclipse
+// shadows and procedural surfaces.
+
+#include "frame.glsl"
+
+// Froxel grid of ClusteredLights, see ClusterData
+layout(std140) uniform Clusters {
+    uvec4 clusterGrid;   // x, y, z froxels, light count
+    uvec4 clusterBases;  // first light, range and index texel of this frame
+    vec4 clusterDepth;   // near, slices per log unit, tile width, tile height
+};
+uniform samplerBuffer clusterLights;    // position, range; color, shadowed
+uniform usamplerBuffer clusterRanges;   // first, count per froxel
+uniform usamplerBuffer clusterIndices;  // light numbers
+
+// Occluder lists of EclipseShadows: MAX_OCCLUDERS spheres (centre, radius) each,
+// ended early by a zero radius
+const int MAX_OCCLUDERS = 4;
+uniform samplerBuffer occluders;
+uniform int occluderBase;
+// Radius of the light the lists were built for
+uniform float lightRadius;
+
+// Faces of PlanetSurfaces, six layers per surface
+uniform sampler2DArray surfaceColors;   // albedo, specular strength
+uniform sampler2DArray surfaceNormals;  // object-space normal in [0, 1]
+
+// Array coordinate of an object-space direction on a surface whose first face
+// is layer - 1, with faces ordered and oriented as GL cube maps
+vec3 surfaceCoordinate(vec3 dir, float layer) {
+    vec3 a = abs(dir);
+    float face;
+    vec2 uv;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = dir.x > 0.0 ? 0.0 : 1.0;
+        uv = vec2(dir.x > 0.0 ? -dir.z : dir.z, -dir.y) / a.x;
+    } else if (a.y >= a.z) {
+        face = dir.y > 0.0 ? 2.0 : 3.0;
+        uv = vec2(dir.x, dir.y > 0.0 ? dir.z : -dir.z) / a.y;
+    } else {
+        face = dir.z > 0.0 ? 4.0 : 5.0;
+        uv = vec2(dir.z > 0.0 ? dir.x : -dir.x, -dir.y) / a.z;
+    }
+    return vec3(uv * 0.5 + 0.5, floor(layer + 0.5) - 1.0 + face);
+}
+
+// Area of the intersection of two discs of angular radii a and b whose centres
+// are c apart
+float discOverlap(float a, float b, float c) {
+    if (c >= a + b) return 0.0;
+    if (c <= abs(a - b)) {
+        float r = min(a, b);
+        return 3.14159265 * r * r;
+    }
+    float alpha = acos(clamp((c * c + a * a - b * b) / (2.0 * c * a), -1.0, 1.0));
+    float beta = acos(clamp((c * c + b * b - a * a) / (2.0 * c * b), -1.0, 1.0));
+    return a * a * (alpha - 0.5 * sin(2.0 * alpha)) +
+           b * b * (beta - 0.5 * sin(2.0 * beta));
+}
+
+// Fraction of the light's disc seen from pos past the occluders of a list
+// (1-based, 0 for none). Overlapping occluders are treated as independent.
+float eclipse(vec3 pos, vec3 light, float list) {
+    if (list < 0.5) return 1.0;
+    int base = occluderBase + (int(list + 0.5) - 1) * MAX_OCCLUDERS;
+
+    vec3 toLight = light - pos;
+    float lightDist = length(toLight);
+    float a = asin(min(lightRadius / lightDist, 1.0));
+    float lightArea = 3.14159265 * a * a;
+
+    float visible = 1.0;
+    for (int i = 0; i < MAX_OCCLUDERS; i++) {
+        vec4 occluder = texelFetch(occluders, base + i);
+        if (occluder.w == 0.0) break;
+
+        vec3 toOccluder = occluder.xyz - pos;
+        float dist = length(toOccluder);
+        // Beyond the light, or the fragment is inside it (its own body)
+        if (dist >= lightDist || dist <= occluder.w) continue;
+
+        float b = asin(occluder.w / dist);
+        float c = acos(clamp(dot(toLight, toOccluder) / (lightDist * dist), -1.0, 1.0));
+        visible *= 1.0 - min(discOverlap(a, b, c) / lightArea, 1.0);
+    }
+    return visible;
+}
+
+// Sum of the diffuse and specular terms of every light listed in the froxel
+// holding this fragment. Falloff reaches zero at each light's range.
+vec3 clusterLighting(vec3 pos, vec3 norm, vec3 cameraDir, vec3 albedo, vec4 material) {
+    float depth = max(-(view * vec4(pos, 1.0)).z, clusterDepth.x);
+    uvec3 cell = uvec3(gl_FragCoord.xy / clusterDepth.zw,
+                       log(depth / clusterDepth.x) * clusterDepth.y);
+    cell = min(cell, clusterGrid.xyz - 1u);
+    int froxel = int((cell.z * clusterGrid.y + cell.y) * clusterGrid.x + cell.x);
+    uvec2 range = texelFetch(clusterRanges, int(clusterBases.y) + froxel).xy;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        uint index = clusterBases.z + range.x + i;
+        int light = int(texelFetch(clusterIndices, int(index)).x);
+        int texel = (int(clusterBases.x) + light) * 2;
+        vec4 positionRange = texelFetch(clusterLights, texel);
+        vec4 colorShadowed = texelFetch(clusterLights, texel + 1);
+
+        vec3 toLight = positionRange.xyz - pos;
+        float dist = length(toLight);
+        float falloff = clamp(1.0 - (dist * dist) / (positionRange.w * positionRange.w),
+                              0.0, 1.0);
+        falloff *= falloff;
+        if (falloff == 0.0) continue;
+        if (colorShadowed.a > 0.5)
+            falloff *= eclipse(pos, positionRange.xyz, material.w);
+        if (falloff == 0.0) continue;
+
+        vec3 lightDir = toLight / dist;
+        float diff = max(dot(norm, lightDir), 0.0);
+        float spec =
+            pow(max(dot(cameraDir, reflect(-lightDir, norm)), 0.0), material.z);
+        result += falloff * colorShadowed.rgb *
+                  (diff * albedo * lightDiffuse + material.y * spec * lightSpecular);
+    }
+    return result;
+}
+
+// Replaces the flat colour, material and normal of a fragment with its
+// PlanetSurfaces texels when the body has a surface. dir is the object-space
+// direction of the fragment, rotation takes object to world space.
+void applySurface(vec3 dir, float layer, mat3 rotation, inout vec3 albedo,
+                  inout vec4 material, inout vec3 norm) {
+    if (layer < 0.5) return;
+    vec3 coordinate = surfaceCoordinate(dir, layer);
+    vec4 surface = texture(surfaceColors, coordinate);
+    albedo = surface.rgb;
+    material.y *= surface.a;
+    vec3 normal = texture(surfaceNormals, coordinate).xyz * 2.0 - 1.0;
+    norm = normalize(rotation * normal);
+}
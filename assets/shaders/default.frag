@@ -1,6 +1,18 @@
 #version 330 core
+#ifdef LOG_DEPTH
+in float ClipW;
+#endif
 
 out vec4 FragColor;
 uniform vec3 color;
 
-void main() { FragColor = vec4(color, 1.0); }
\ No newline at end of file
+#include "frame.glsl"
+
+#include "depth.glsl"
+
+void main() {
+#ifdef LOG_DEPTH
+    gl_FragDepth = logarithmicDepth(ClipW);
+#endif
+    FragColor = vec4(color, 1.0);
+}
@@ -2,11 +2,17 @@
 layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame.glsl"
+
+#ifdef LOG_DEPTH
+out float ClipW;  // for the fragment depth
+#endif
 
 void main()
 {
     // note that we read the multiplication from right to left
     gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef LOG_DEPTH
+    ClipW = gl_Position.w;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,29 @@
+// Depth shared by every program. Programs built with LOG_DEPTH (see Shader)
+// store log2(1 + w), scaled to [0, 1] over the view range by logDepth, so one
+// pass holds the whole scene. Only they write gl_FragDepth from rasterized
+// geometry, since writing it turns off early and hierarchical depth testing.
+
+#include "frame.glsl"
+
+#ifdef LOG_DEPTH
+float logarithmicDepth(float w) { return log2(1.0 + max(w, 0.0)) * logDepth; }
+#endif
+
+// Depth of a clip-space point, for shaders that find their own surface
+float clipDepth(vec4 clip) {
+#ifdef LOG_DEPTH
+    return logarithmicDepth(clip.w);
+#else
+    return 0.5 * (gl_DepthRange.diff * (clip.z / clip.w) + gl_DepthRange.near +
+                  gl_DepthRange.far);
+#endif
+}
+
+// Clip position of a point sprite: a point has a single depth, so unlike other
+// primitives it can take logarithmic depth from the vertex shader exactly
+vec4 pointClip(vec4 clip) {
+#ifdef LOG_DEPTH
+    clip.z = (2.0 * logarithmicDepth(clip.w) - 1.0) * clip.w;
+#endif
+    return clip;
+}
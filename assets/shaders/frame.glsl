@@ -0,0 +1,16 @@
+// Per-frame camera and light state shared by every program, uploaded by
+// FrameUniforms. Keep in step with FrameData, which mirrors its std140 layout.
+#ifndef FRAME_GLSL
+#define FRAME_GLSL
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    vec3 cameraPos;
+    float time;
+    vec3 lightPosition;
+    vec3 lightAmbient;
+    vec3 lightDiffuse;
+    vec3 lightSpecular;
+    float logDepth;  // 1 / log2(far + 1), see depth.glsl
+};
+#endif
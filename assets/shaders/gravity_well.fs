@@ -1,13 +1,22 @@
 #version 330 core
 in vec3 FragPos;
+#ifdef LOG_DEPTH
+in float ClipW;
+#endif
 
 uniform vec3 gridColor;
 uniform float mapSize;
-uniform vec3 cameraPos;
+
+#include "frame.glsl"
+
+#include "depth.glsl"
 
 out vec4 FragColor;
 
 void main() {
+#ifdef LOG_DEPTH
+    gl_FragDepth = logarithmicDepth(ClipW);
+#endif
     float fragDistance = length(vec3(cameraPos.x, 0.0, cameraPos.z) - FragPos);
 
     FragColor = vec4(gridColor, 1.0 - (fragDistance / (mapSize/2)));
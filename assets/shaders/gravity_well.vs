@@ -2,13 +2,18 @@
 layout(location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "frame.glsl"
 
 out vec3 FragPos;
+#ifdef LOG_DEPTH
+out float ClipW;  // for the fragment depth
+#endif
 
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef LOG_DEPTH
+    ClipW = gl_Position.w;
+#endif
     FragPos = (model * vec4(aPos, 1.0)).xyz;
 }
\ No newline at end of file
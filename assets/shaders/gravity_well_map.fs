@@ -0,0 +1,27 @@
+#version 330 core
+in vec3 FragPos;
+in float Slope;
+#ifdef LOG_DEPTH
+in float ClipW;
+#endif
+
+uniform vec3 gridColor;
+uniform vec3 slopeColor;
+uniform float slopeScale;
+uniform float mapSize;
+
+#include "frame.glsl"
+
+#include "depth.glsl"
+
+out vec4 FragColor;
+
+void main() {
+#ifdef LOG_DEPTH
+    gl_FragDepth = logarithmicDepth(ClipW);
+#endif
+    float fragDistance = length(vec3(cameraPos.x, 0.0, cameraPos.z) - FragPos);
+    vec3 color = mix(gridColor, slopeColor, clamp(Slope * slopeScale, 0.0, 1.0));
+
+    FragColor = vec4(color, 1.0 - (fragDistance / (mapSize/2)));
+}
@@ -0,0 +1,56 @@
+#version 330 core
+layout(location = 0) in vec2 aGrid;
+
+#include "frame.glsl"
+
+uniform sampler2D heightMap;
+uniform vec2 windowOrigin;
+uniform float windowSize;
+uniform float texelCount;
+uniform float planeHeight;
+
+out vec3 FragPos;
+out float Slope;
+#ifdef LOG_DEPTH
+out float ClipW;  // for the fragment depth
+#endif
+
+// Texel k holds the grid vertex whose world cell index is k modulo texelCount.
+// Cells are clamped to the window first, so samples at its rim never reach the
+// texels of the opposite edge.
+float texelAt(ivec2 cell) {
+    int count = int(texelCount + 0.5);
+    ivec2 first = ivec2(floor(windowOrigin / (windowSize / texelCount) + 0.5));
+    cell = clamp(cell, first, first + ivec2(count - 1));
+    return texelFetch(heightMap, ((cell % count) + count) % count, 0).r;
+}
+
+// Bilinear over the four surrounding grid vertices
+float depthAt(vec2 world) {
+    vec2 position = world / (windowSize / texelCount);
+    ivec2 cell = ivec2(floor(position));
+    vec2 f = position - floor(position);
+    float near = mix(texelAt(cell), texelAt(cell + ivec2(1, 0)), f.x);
+    float far = mix(texelAt(cell + ivec2(0, 1)), texelAt(cell + ivec2(1, 1)), f.x);
+    return mix(near, far, f.y);
+}
+
+void main()
+{
+    // Stop one cell short: the window holds texelCount vertices per side
+    float cellSize = windowSize / texelCount;
+    vec2 world = windowOrigin + aGrid * (windowSize - cellSize);
+
+    vec2 gradient = vec2(depthAt(world + vec2(cellSize, 0.0)) -
+                             depthAt(world - vec2(cellSize, 0.0)),
+                         depthAt(world + vec2(0.0, cellSize)) -
+                             depthAt(world - vec2(0.0, cellSize))) /
+                    (2.0 * cellSize);
+    Slope = length(gradient);
+
+    FragPos = vec3(world.x, planeHeight - depthAt(world), world.y);
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+#ifdef LOG_DEPTH
+    ClipW = gl_Position.w;
+#endif
+}
@@ -0,0 +1,52 @@
+#version 330 core
+in vec3 FragPos;
+flat in vec3 Center;
+flat in float Radius;
+flat in vec4 Color;
+flat in vec4 Material;
+flat in mat3 Rotation;
+flat in float SurfaceLayer;
+
+#include "frame.glsl"
+
+#include "depth.glsl"
+
+#include "body_lighting.glsl"
+
+out vec4 FragColor;
+
+void main() {
+    // Intersect the view ray through this fragment with the sphere
+    vec3 rayDir = normalize(FragPos - cameraPos);
+    vec3 oc = cameraPos - Center;
+    float b = dot(oc, rayDir);
+    float c = dot(oc, oc) - Radius * Radius;
+    float h = b * b - c;
+    if (h < 0.0) discard;
+
+    vec3 hit = cameraPos + (-b - sqrt(h)) * rayDir;
+
+    vec4 clip = projection * view * vec4(hit, 1.0);
+    gl_FragDepth = clipDepth(clip);
+
+    // Emissive bodies (stars) are not lit
+    if (Color.a > 0.5) {
+        FragColor = vec4(Color.rgb, 1.0);
+        return;
+    }
+
+    // Same lighting as planet.fs
+    vec3 norm = (hit - Center) / Radius;
+    vec3 albedo = Color.rgb;
+    vec4 material = Material;
+    vec3 objectDir = transpose(Rotation) * norm;
+    applySurface(objectDir, SurfaceLayer, Rotation, albedo, material, norm);
+
+    vec3 ambient = material.x * albedo * lightAmbient;
+
+    vec3 cameraDir = -rayDir;
+    vec3 lit = clusterLighting(hit, norm, cameraDir, albedo, material);
+
+    vec3 result = ambient + lit;
+    FragColor = vec4(result, 1.0);
+}
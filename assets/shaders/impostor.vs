@@ -0,0 +1,42 @@
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+
+// Per-instance attributes, see BodyInstance
+layout(location = 2) in mat4 aModel;
+layout(location = 6) in vec4 aColor;
+layout(location = 7) in vec4 aMaterial;
+layout(location = 8) in vec4 aSurface;
+
+#include "frame.glsl"
+
+out vec3 FragPos;
+flat out vec3 Center;
+flat out float Radius;
+flat out vec4 Color;
+flat out vec4 Material;
+// Rotation from object to world space and the surface layer
+flat out mat3 Rotation;
+flat out float SurfaceLayer;
+
+void main() {
+    Center = aModel[3].xyz;
+    Radius = length(aModel[0].xyz);
+
+    // The quad faces the camera and is sized to the sphere's silhouette cone at
+    // the centre's distance, so it covers the sphere exactly under perspective
+    vec3 toCamera = cameraPos - Center;
+    float dist = max(length(toCamera), Radius * 1.001);
+    vec3 forward = toCamera / dist;
+    vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(up, forward));
+    up = cross(forward, right);
+    float halfSize = Radius * dist / sqrt(dist * dist - Radius * Radius);
+
+    FragPos = Center + (aCorner.x * right + aCorner.y * up) * halfSize;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+
+    Color = aColor;
+    Material = aMaterial;
+    Rotation = mat3(aModel) / Radius;
+    SurfaceLayer = aSurface.x;
+}
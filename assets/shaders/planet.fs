@@ -1,43 +1,43 @@
 #version 330 core
 in vec3 Normal;
 in vec3 FragPos;
+in vec4 Color;
+in vec4 Material;
+in vec3 ObjectDir;
+flat in mat3 Rotation;
+flat in float SurfaceLayer;
+#ifdef LOG_DEPTH
+in float ClipW;
+#endif
 
-struct Material {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-};
-uniform Material material;
+#include "frame.glsl"
 
-struct Light {
-    vec3 position;
+#include "depth.glsl"
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-uniform Light light;
-
-uniform vec3 cameraPos;
+#include "body_lighting.glsl"
 
 out vec4 FragColor;
 
-
 void main() {
-    vec3 ambient = material.ambient * light.ambient;
+#ifdef LOG_DEPTH
+    gl_FragDepth = logarithmicDepth(ClipW);
+#endif
+    // Emissive bodies (stars) are not lit
+    if (Color.a > 0.5) {
+        FragColor = vec4(Color.rgb, 1.0);
+        return;
+    }
 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(light.position - FragPos);
+    vec3 albedo = Color.rgb;
+    vec4 material = Material;
+    applySurface(ObjectDir, SurfaceLayer, Rotation, albedo, material, norm);
 
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * material.diffuse * light.diffuse;
+    vec3 ambient = material.x * albedo * lightAmbient;
 
     vec3 cameraDir = normalize(cameraPos - FragPos);
-    float specularDiff =
-        pow(max(dot(cameraDir, reflect(-lightDir, norm)), 0.0), material.shininess);
-    vec3 specular = material.specular * specularDiff * light.specular;
+    vec3 lit = clusterLighting(FragPos, norm, cameraDir, albedo, material);
 
-    vec3 result = ambient + diffuse + specular;
+    vec3 result = ambient + lit;
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -2,16 +2,39 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-instance attributes, see BodyInstance
+layout(location = 2) in mat4 aModel;
+layout(location = 6) in vec4 aColor;
+layout(location = 7) in vec4 aMaterial;
+layout(location = 8) in vec4 aSurface;
+
+#include "frame.glsl"
 
 out vec3 Normal;
 out vec3 FragPos;
+out vec4 Color;
+out vec4 Material;
+// Unit sphere direction, the rotation to world space and the surface layer
+out vec3 ObjectDir;
+flat out mat3 Rotation;
+flat out float SurfaceLayer;
+#ifdef LOG_DEPTH
+out float ClipW;  // for the fragment depth
+#endif
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FragPos = (model * vec4(aPos, 1.0)).xyz;
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+#ifdef LOG_DEPTH
+    ClipW = gl_Position.w;
+#endif
+    FragPos = (aModel * vec4(aPos, 1.0)).xyz;
+    // Bodies are only ever uniformly scaled, so the model matrix itself
+    // transforms normals correctly
+    Normal = mat3(aModel) * aNormal;
 
-}
\ No newline at end of file
+    Color = aColor;
+    Material = aMaterial;
+    ObjectDir = aPos;
+    Rotation = mat3(aModel) / length(aModel[0].xyz);
+    SurfaceLayer = aSurface.x;
+}
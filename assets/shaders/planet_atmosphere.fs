@@ -0,0 +1,84 @@
+#version 330 core
+in vec3 FragPos;
+flat in vec3 Center;
+flat in float Radius;
+
+#include "frame.glsl"
+
+#include "depth.glsl"
+
+// Tables of Atmosphere; lengths in planet radii
+uniform sampler2D transmittanceTable;  // (mu, r)
+uniform sampler3D scatteringTable;     // (mu, mu_s, r)
+uniform float atmosphereTop;
+uniform vec3 rayleighScattering;
+uniform float mieG;
+
+uniform vec3 sunPosition;
+uniform vec3 sunRadiance;
+
+out vec4 FragColor;
+
+float heightCoordinate(float r) {
+    return sqrt(clamp((r - 1.0) / (atmosphereTop - 1.0), 0.0, 1.0));
+}
+
+vec3 transmittance(float r, float mu) {
+    return texture(transmittanceTable, vec2(mu * 0.5 + 0.5, heightCoordinate(r))).rgb;
+}
+
+void main() {
+    // Work in planet radii around the planet's centre
+    vec3 rayDir = normalize(FragPos - cameraPos);
+    vec3 origin = (cameraPos - Center) / Radius;
+
+    float b = dot(origin, rayDir);
+    float c = dot(origin, origin) - atmosphereTop * atmosphereTop;
+    float h = b * b - c;
+    if (h < 0.0) discard;
+    float exit = -b + sqrt(h);
+    if (exit <= 0.0) discard;
+    float entry = max(-b - sqrt(h), 0.0);
+
+    vec3 start = origin + entry * rayDir;
+    float r = length(start);
+    float mu = dot(start, rayDir) / r;
+    vec3 sunDir = normalize(sunPosition - Center);
+    float muS = dot(start, sunDir) / r;
+    float nu = dot(rayDir, sunDir);
+
+    // Light scattered towards the camera, with the phase functions applied here
+    vec3 coordinate = vec3(mu * 0.5 + 0.5, muS * 0.5 + 0.5, heightCoordinate(r));
+    vec4 scattered = texture(scatteringTable, coordinate);
+    vec3 rayleigh = scattered.rgb;
+    vec3 mie = scattered.rgb * scattered.a / max(scattered.r, 1e-6) *
+               (rayleighScattering.r / rayleighScattering);
+    float rayleighPhase = 3.0 / (16.0 * 3.14159265) * (1.0 + nu * nu);
+    float g2 = mieG * mieG;
+    float miePhase = 3.0 / (8.0 * 3.14159265) * (1.0 - g2) * (1.0 + nu * nu) /
+                     ((2.0 + g2) * pow(1.0 + g2 - 2.0 * mieG * nu, 1.5));
+    vec3 inscatter = sunRadiance * (rayleigh * rayleighPhase + mie * miePhase);
+
+    // Transmittance along the view ray dims what lies behind the shell. Rays
+    // that reach the ground use the reversed ray, which stays above it.
+    c = dot(origin, origin) - 1.0;
+    h = b * b - c;
+    vec3 viewT;
+    if (h >= 0.0 && -b - sqrt(h) > 0.0) {
+        vec3 ground = origin + (-b - sqrt(h)) * rayDir;
+        float muGround = dot(ground, rayDir);
+        viewT = transmittance(1.0, -muGround) /
+                max(transmittance(r, -mu), vec3(1e-6));
+    } else {
+        viewT = transmittance(r, mu);
+    }
+    float opacity = 1.0 - clamp(dot(viewT, vec3(1.0 / 3.0)), 0.0, 1.0);
+
+    // Depth of the shell's near side, so bodies in front still cover it
+    vec3 near = Center + (start + 1e-4 * rayDir) * Radius;
+    vec4 clip = projection * view * vec4(near, 1.0);
+    gl_FragDepth = clipDepth(clip);
+
+    // Premultiplied: the scattered light plus 1 - opacity of the background
+    FragColor = vec4(inscatter, opacity);
+}
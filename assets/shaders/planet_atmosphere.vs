@@ -0,0 +1,38 @@
+#version 330 core
+layout(location = 0) in vec2 aCorner;
+layout(location = 1) in vec4 aPlanet;  // centre, planet radius
+
+#include "frame.glsl"
+
+// Outer radius of the atmosphere, in planet radii
+uniform float atmosphereTop;
+
+out vec3 FragPos;
+flat out vec3 Center;
+flat out float Radius;
+
+void main() {
+    Center = aPlanet.xyz;
+    Radius = aPlanet.w;
+    float outer = Radius * atmosphereTop;
+
+    vec3 toCamera = cameraPos - Center;
+    float dist = length(toCamera);
+    if (dist <= outer * 1.001) {
+        // Inside the shell, which then covers the whole screen
+        gl_Position = vec4(aCorner, -1.0, 1.0);
+        vec4 world = inverse(projection * view) * gl_Position;
+        FragPos = world.xyz / world.w;
+        return;
+    }
+
+    // Camera-facing quad over the shell's silhouette, as in impostor.vs
+    vec3 forward = toCamera / dist;
+    vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(up, forward));
+    up = cross(forward, right);
+    float halfSize = outer * dist / sqrt(dist * dist - outer * outer);
+
+    FragPos = Center + (aCorner.x * right + aCorner.y * up) * halfSize;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 330 core
+in vec3 Color;
+
+out vec4 FragColor;
+
+void main() {
+    // Round sprite with a soft edge whose mean over the disc is one; blended
+    // additively
+    vec2 offset = gl_PointCoord * 2.0 - 1.0;
+    float r2 = dot(offset, offset);
+    if (r2 > 1.0) discard;
+
+    FragColor = vec4(Color * (2.0 * (1.0 - r2)), 1.0);
+}
@@ -0,0 +1,46 @@
+#version 330 core
+layout(location = 0) in vec4 aSphere;  // centre, radius
+layout(location = 1) in vec4 aColor;   // a = 1 for emissive bodies
+
+#include "frame.glsl"
+
+#include "depth.glsl"
+
+// Pixels per world unit at distance 1, set by BodyRenderer
+uniform float pixelScale;
+// Points fainter than this apparent magnitude are dropped
+uniform float limitingMagnitude;
+// Largest sprite diameter, in pixels
+uniform float maxPointSize;
+
+out vec3 Color;
+
+void main() {
+    vec3 center = aSphere.xyz;
+    float dist = length(cameraPos - center);
+    float screenRadius = aSphere.w * pixelScale / dist;
+
+    // Light received by the eye, in units of one fully lit pixel: the projected
+    // disc area, times the lit fraction of the disc for bodies that reflect
+    float flux = 3.14159265 * screenRadius * screenRadius;
+    if (aColor.a < 0.5) {
+        vec3 toCamera = (cameraPos - center) / dist;
+        vec3 toLight = normalize(lightPosition - center);
+        flux *= 0.5 * (1.0 + dot(toCamera, toLight));
+    }
+    float magnitude = -2.5 * log(max(flux, 1e-12)) / log(10.0);
+
+    gl_Position = pointClip(projection * view * vec4(center, 1.0));
+    if (magnitude > limitingMagnitude) {
+        // Outside the clip volume, so the point is discarded before rasterizing
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Color = vec3(0.0);
+        return;
+    }
+
+    // Brighter points bloom: the sprite grows by one pixel per magnitude above
+    // zero, and the flux is spread over its area so total light is preserved
+    float size = clamp(2.0 * screenRadius + max(-magnitude, 0.0), 1.0, maxPointSize);
+    gl_PointSize = size;
+    Color = aColor.rgb * flux / (0.785398 * size * size);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+layout(location = 0) in vec4 aStar;   // direction, magnitude
+layout(location = 1) in vec4 aColor;
+
+#include "frame.glsl"
+
+// Magnitude whose light is a twentieth of a pixel at the current exposure,
+// see Starfield::limitingMagnitude. Fainter stars are dropped.
+uniform float limitingMagnitude;
+// Largest sprite diameter, in pixels
+uniform float maxPointSize;
+
+out vec3 Color;
+
+void main() {
+    if (aStar.w > limitingMagnitude) {
+        // Outside the clip volume, so the point is discarded before rasterizing
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        Color = vec3(0.0);
+        return;
+    }
+
+    // At infinity: rotate with the camera but never translate, and sit just
+    // inside the far plane so every body is drawn in front. The far plane is
+    // depth one with LOG_DEPTH too, so this holds in both variants.
+    vec4 clip = projection * vec4(mat3(view) * aStar.xyz, 1.0);
+    gl_Position = vec4(clip.xy, clip.w * 0.99999, clip.w);
+
+    // Light in units of one fully lit pixel; a star at the limit gives a
+    // twentieth of one. The limit carries the exposure.
+    float flux = 0.05 * pow(10.0, 0.4 * (limitingMagnitude - aStar.w));
+    float magnitude = -2.5 * log(max(flux, 1e-12)) / log(10.0);
+
+    // Bloom like point_sprite.vs: one pixel per magnitude above zero, with the
+    // flux spread over the sprite
+    float size = clamp(1.0 + max(-magnitude, 0.0), 1.0, maxPointSize);
+    gl_PointSize = size;
+    Color = aColor.rgb * flux / (0.785398 * size * size);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Celestial_Body.h"
+#include "Renderer/BodyRenderer.h"
+
+// Massless test particles on circular orbits around one body. They feel only
+// that body, so their positions are closed-form in time and a belt of a
+// million asteroids costs one parallel pass per frame.
+class AsteroidBelt {
+   public:
+    float innerRadius = 3000.0f;
+    float outerRadius = 4500.0f;
+    float maxInclination = 0.05f;  // radians
+    float minSize = 1.0f, maxSize = 8.0f;
+
+    glm::vec3 color = glm::vec3(0.6f, 0.55f, 0.5f);
+    glm::vec3 material = glm::vec3(1.0f, 0.1f, 4.0f);
+
+    // Regenerates the orbits; the same count always gives the same belt
+    void resize(size_t count);
+    // Sets the belt's clock to the simulated time
+    void setTime(double time) { this->time = time; }
+    // Places every asteroid around the centre body at the current time
+    void update(const Body& center);
+    void submit(BodyRenderer& renderer) const;
+
+    size_t size() const { return orbits.size(); }
+    // As of the last update()
+    const std::vector<glm::vec3>& asteroidPositions() const { return positions; }
+    const std::vector<float>& asteroidSizes() const { return sizes; }
+
+   private:
+    struct Orbit {
+        float radius;
+        float phase;
+        float inclination;
+        float node;
+    };
+
+    std::vector<Orbit> orbits;
+    std::vector<glm::vec3> positions;
+    std::vector<float> sizes;
+    double time = 0.0;
+};
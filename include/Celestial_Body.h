@@ -1,7 +1,9 @@
 #ifndef CELESTIAL_BODY_H
 #define CELESTIAL_BODY_H
 
+#include "Renderer/BodyRenderer.h"
 #include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
 
 #include <glad/glad.h>
 #include <glm/ext/matrix_transform.hpp>
@@ -10,6 +12,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <glm/trigonometric.hpp>
+#include <string>
 #include <vector>
 
 extern const float PI;
@@ -19,28 +22,50 @@ class Body {
     glm::vec3 position;
     glm::vec3 velocity;
     float mass;
-
-    Body(glm::vec3 position, glm::vec3 velocity, float mass)
-        : position(position), velocity(velocity), mass(mass) {
+    std::string name;
+    // EclipseShadows list of this body for the frame, 0 for none
+    float shadowList = 0.0f;
+    // PlanetSurfaces layer of this body, 0 for its flat colour
+    float surfaceLayer = 0.0f;
+
+    Body(glm::vec3 position, glm::vec3 velocity, float mass, float radius = 0.0f)
+        : position(position), velocity(velocity), mass(mass), radius(radius) {
         initOrbitVertexData();
     }
+    virtual ~Body();
+
+    // Owns its orbit vertex array and stream, so it moves but does not copy
+    Body(Body&& other) noexcept;
+    Body(const Body&) = delete;
+    Body& operator=(const Body&) = delete;
 
-    // void predictPositions(std::vector<GLfloat>& positionVector,
-    //                       const std::vector<Body*>& other_bodies, glm::vec3
-    //                       position, glm::vec3 velocity, float timestep, unsigned
-    //                       int steps);
+    // time: seconds of SimulationSnapshot::clock, which sets the spin
+    virtual void submit(BodyRenderer& renderer, float time) const = 0;
+
+    float boundingRadius() const { return radius; }
+    // Bounding sphere (centre, radius) of the last predicted orbit
+    glm::vec4 orbitBounds() const { return orbitSphere; }
+    GLuint orbitVertexArray() const { return orbitVAO; }
 
-    std::vector<GLfloat> predictPositions(const Body& me,
-                                          const std::vector<Body*>& others,
-                                          float timestep, unsigned int steps);
     void drawOrbit(Shader& shader);
     void updateOrbitVertexData();
 
+    // Predicted orbit as xyz triples
+    const std::vector<GLfloat>& orbit() const { return orbitVertices; }
+    // Replaces the predicted orbit and refreshes its bounds
+    void setOrbit(const std::vector<GLfloat>& path);
+
    protected:
-    GLuint orbitVAO, orbitVBO, orbitEBO;
+    float radius;
+
+    GLuint orbitVAO = 0, orbitEBO = 0;
+    StreamBuffer orbitStream{GL_ARRAY_BUFFER, 3 * sizeof(GLfloat)};
+    unsigned int orbitGeneration = 0;
+    GLsizei orbitVertexCount = 0;  // vertices in the current stream region
 
     std::vector<GLfloat> orbitVertices;
     std::vector<GLuint> orbitIndices;
+    glm::vec4 orbitSphere = glm::vec4(0.0f);
 
     void initOrbitVertexData();
 };
@@ -51,26 +76,15 @@ class Planet : public Body {
     Planet(glm::vec3 position, glm::vec3 velocity, float mass = 500.0f,
            float radius = 1.0f);
 
-    void render(const Shader& shader);
-    void update(const std::vector<Body*>& other_bodies, float delta_time);
+    void submit(BodyRenderer& renderer, float time) const override;
 
    private:
     // Physical Attributes
-    float radius;
     float angular_speed = glm::radians(-50.0f);
 
-    glm::vec3 color = glm::vec3(1.0f, 1.0f, 0.0f);
-
-    // Vertex Data
-    GLuint shader_ID;
-    GLuint VAO;
-    std::vector<GLuint> indices;
-    std::vector<GLuint> line_indices;
-
-    unsigned int latCount = 36;
-    unsigned int longCount = 18;
-
-    void initVertexData();
+    glm::vec3 color = glm::vec3(1.0f, 0.5f, 0.31f);
+    // Ambient strength, specular strength, shininess
+    glm::vec3 material = glm::vec3(1.0f, 0.5f, 10.0f);
 };
 
 class Star : public Body {
@@ -79,23 +93,10 @@ class Star : public Body {
 
     Star(glm::vec3 position, glm::vec3 velocity, float mass, float radius);
 
-    void render(const Shader& shader);
-    void update(const std::vector<Body*>& other_bodies, float delta_time);
+    void submit(BodyRenderer& renderer, float time) const override;
 
    private:
-    float radius;
     float angular_speed = glm::radians(-50.0f);
-
-    // Vertex Data
-    GLuint shader_ID;
-    GLuint VAO;
-    std::vector<GLuint> indices;
-    std::vector<GLuint> line_indices;
-
-    unsigned int latCount = 36;
-    unsigned int longCount = 18;
-
-    void initVertexData();
 };
 
 #endif
\ No newline at end of file
@@ -7,20 +7,108 @@
 #include "Camera.h"
 #include "Celestial_Body.h"
 #include "Renderer/Shader.h"
+#include "RotatingFrame.h"
 
 class GravityWell {
    public:
+    // Grid cells per tile edge. Tiles are the unit of caching and upload.
+    static const unsigned int TILE_SIZE = 16;
+    // Bodies past this many share one cached contribution per tile, which is
+    // rebuilt whenever any of them moves, so the cache stays bounded
+    static const unsigned int MAX_CACHED_BODIES = 16;
+
+    // RENDER_LINES uploads the displaced line mesh; RENDER_HEIGHTMAP uploads only
+    // depth texels and displaces a static grid in the vertex shader
+    enum RenderMode { RENDER_LINES = 0, RENDER_HEIGHTMAP = 1 };
+
     GLfloat gridSize;
     GLfloat mapSize = 10000.0f;
+    GLfloat planeHeight = 50.0f;
+    GLfloat depthScale = 2.0e5f;
+    // A body's cached contribution to a tile is reused until the body has moved
+    // further than this fraction of its distance to the tile
+    GLfloat dirtyTolerance = 0.01f;
+
+    int renderMode = RENDER_LINES;
+    // Lines per side of the height map grid, independent of the sampled resolution
+    int meshResolution = 256;
+    bool slopeShading = true;
+    GLfloat slopeScale = 2.0f;
+
     GravityWell(GLfloat gridSize);
 
-    void render(const Shader& shader, const Camera& camera);
-    void updateVertexData(const Camera& camera, const std::vector<Body*>& other_bodies);
+    void render(const Shader& shader);
+    void renderHeightMap(const Shader& shader);
+    // With a valid frame the well shows that pair's co-rotating effective potential
+    void updateVertexData(const Camera& camera, const std::vector<Body*>& other_bodies,
+                          const RotatingFrame* frame = nullptr);
+
+    unsigned int tileCount() const { return tilesPerSide * tilesPerSide; }
+    unsigned int dirtyTileCount() const { return dirtyTiles; }
+    // Bumped whenever any tile changes, so consumers can skip unchanged wells
+    unsigned long revision() const { return wellRevision; }
+
+    // Tile-major vertex data: slot s owns tileVertexCount() xyz vertices starting
+    // at s * tileVertexCount() * 3, laid out as [x][z] over (TILE_SIZE + 1)^2
+    const std::vector<GLfloat>& getVertices() const { return vertices; }
+    static unsigned int tileVertexCount() {
+        return (TILE_SIZE + 1) * (TILE_SIZE + 1);
+    }
 
    private:
+    // The well is a window of tilesPerSide x tilesPerSide tiles around the camera.
+    // World tiles map onto slots toroidally, so when the camera crosses a tile
+    // boundary only the row/column of tiles that scrolled into view is rebuilt.
+    struct Tile {
+        int worldX = 0, worldZ = 0;  // world tile coordinates held by this slot
+        bool valid = false;
+        std::vector<glm::vec3> bodyPositions;  // positions the cache was built from
+        unsigned long frameRevision = 0;  // non-zero: holds that effective potential
+    };
+
+    std::vector<Tile> tiles;
+    unsigned int tilesPerSide = 0;
+    unsigned int dirtyTiles = 0;
+    unsigned long wellRevision = 0;
+    size_t bodyCount = 0;
+    GLfloat layoutGridSize = 0.0f;
+
+    // Per slot, (TILE_SIZE + 1)^2 vertices so every tile is self-contained and the
+    // index buffer never changes while scrolling
     std::vector<GLfloat> vertices;
     std::vector<GLuint> indices;
+    // Per slot and contribution layer, the well depth added at each tile vertex:
+    // one layer per body up to MAX_CACHED_BODIES, then one for all the rest
+    std::vector<GLfloat> contributions;
+    // Window position in whole tiles, to find the slots on its far edges
+    int windowTileX = 0, windowTileZ = 0;
+    // Far x and far z edge lines of every slot, after the slot lines in EBO.
+    // Only the slots on the window's far side draw theirs.
+    GLsizei edgeIndexOffset = 0;
+    std::vector<GLsizei> edgeCounts;
+    std::vector<const void*> edgeOffsets;
 
     GLuint VAO, VBO, EBO;
+
+    // Height map: one R32F texel per grid vertex, addressed toroidally like the
+    // slots, so a dirty tile maps to one TILE_SIZE^2 sub-image
+    GLuint heightMap;
+    GLuint mapVAO, mapVBO, mapEBO;
+    GLsizei mapIndexCount = 0;
+    int builtMeshResolution = 0;
+    int uploadedMode = -1;
+    glm::vec2 windowOrigin = glm::vec2(0.0f);
+    std::vector<GLfloat> texelStaging;
+
+    size_t contributionLayers() const;
+    void addContribution(GLfloat* contribution, const glm::vec3& tileMin,
+                         const Body& body, bool accumulate) const;
     void initVertexData();
-};
\ No newline at end of file
+    void initHeightMapMesh();
+    void uploadTexels(unsigned int slot);
+    void initTiles(unsigned int sideTiles);
+    bool updateTile(unsigned int slot, int worldX, int worldZ,
+                    const std::vector<Body*>& other_bodies);
+    bool updateEffectiveTile(unsigned int slot, int worldX, int worldZ,
+                             const RotatingFrame& frame);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "GravityWell.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Isopotential rings over the gravity well, extracted with marching squares.
+// Tiles of the well are processed in parallel and segments are written straight
+// into a mapped streaming VBO.
+class IsoContours {
+   public:
+    int levelCount = 24;
+    glm::vec3 color = glm::vec3(0.3f, 0.8f, 1.0f);
+    // Extra well depths always contoured, e.g. the zero-velocity curves through
+    // the Lagrange points
+    std::vector<GLfloat> pinnedDepths;
+
+    IsoContours();
+
+    // Re-extracts only when the well or the level count changed since last call
+    void update(const GravityWell& well);
+    void render(const Shader& shader, GLfloat mapSize);
+
+    size_t segmentCount() const { return segments; }
+
+   private:
+    // Contour heights in well space (y of the displaced grid), ascending
+    std::vector<GLfloat> levels;
+    // Per tile segment counts from the counting pass, then their prefix sums
+    std::vector<size_t> tileSegments;
+
+    unsigned long extractedRevision = 0;
+    int extractedLevelCount = 0;
+    std::vector<GLfloat> extractedPinned;
+    size_t segments = 0;
+
+    GLuint VAO;
+    StreamBuffer stream{GL_ARRAY_BUFFER, 3 * sizeof(GLfloat)};
+    unsigned int streamGeneration = 0;
+
+    void initVertexData();
+    // Points the VAO at the stream's buffer after it was (re)created
+    void bindStream();
+    void computeLevels(const GravityWell& well);
+    size_t extractTile(const GLfloat* tile, GLfloat* out) const;
+};
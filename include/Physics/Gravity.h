@@ -0,0 +1,92 @@
+#ifndef GRAVITY_H
+#define GRAVITY_H
+
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Celestial_Body.h"
+
+// Newtonian gravity kernels shared by the integrator, orbit prediction and the
+// field visualisations, so every consumer agrees on the same field.
+namespace Gravity {
+
+const float G = 6.67e-11f;
+
+// Acceleration at a point from every body except `exclude`
+inline glm::vec3 acceleration(const glm::vec3& position,
+                              const std::vector<Body*>& bodies,
+                              const Body* exclude = nullptr) {
+    glm::vec3 netAcc(0.0f);
+    for (const Body* body : bodies) {
+        if (body == exclude) continue;
+
+        glm::vec3 distance_vector = body->position - position;
+        float r2 = glm::dot(distance_vector, distance_vector);
+        if (r2 <= 0.0f) continue;
+
+        netAcc += (G * body->mass / r2) * glm::normalize(distance_vector);
+    }
+    return netAcc;
+}
+
+// Magnitude of the potential G * m / r of a single body at a point
+inline float potential(const glm::vec3& position, const Body& body) {
+    float distance_mag = glm::length(body.position - position);
+    if (distance_mag == 0) return 0.0f;
+    return G * body.mass / distance_mag;
+}
+
+// Structure-of-arrays snapshot of the bodies for batched field evaluation. The
+// inner loops run over plain float arrays so the compiler can vectorise them.
+struct Sources {
+    std::vector<float> x, y, z, gm;
+
+    void assign(const std::vector<Body*>& bodies) {
+        size_t count = bodies.size();
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        gm.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            x[i] = bodies[i]->position.x;
+            y[i] = bodies[i]->position.y;
+            z[i] = bodies[i]->position.z;
+            gm[i] = G * bodies[i]->mass;
+        }
+    }
+
+    size_t size() const { return gm.size(); }
+};
+
+// Acceleration at `count` points at once. Also reports, per point, the squared
+// distance to the nearest body so callers can stop before a singularity.
+inline void accelerationBatch(const Sources& sources, const glm::vec3* points,
+                              glm::vec3* out, float* nearest2, size_t count) {
+    for (size_t p = 0; p < count; p++) {
+        float ax = 0.0f, ay = 0.0f, az = 0.0f;
+        float closest = 3.4e38f;
+
+        for (size_t i = 0; i < sources.size(); i++) {
+            float dx = sources.x[i] - points[p].x;
+            float dy = sources.y[i] - points[p].y;
+            float dz = sources.z[i] - points[p].z;
+            float r2 = dx * dx + dy * dy + dz * dz;
+
+            float inv = r2 > 0.0f ? 1.0f / sqrtf(r2) : 0.0f;
+            float scale = sources.gm[i] * inv * inv * inv;
+            ax += dx * scale;
+            ay += dy * scale;
+            az += dz * scale;
+            closest = r2 < closest ? r2 : closest;
+        }
+
+        out[p] = glm::vec3(ax, ay, az);
+        if (nearest2 != nullptr) nearest2[p] = closest;
+    }
+}
+
+}  // namespace Gravity
+
+#endif  // GRAVITY_H
@@ -0,0 +1,110 @@
+#ifndef ATMOSPHERE_H
+#define ATMOSPHERE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Exponential Rayleigh and Mie atmosphere. Lengths are in planet radii, so one
+// set of tables serves planets of any size.
+struct AtmosphereParameters {
+    float top = 1.06f;  // radius of the outer edge
+    glm::vec3 rayleighScattering = glm::vec3(3.09f, 7.2f, 17.7f);
+    float rayleighHeight = 0.015f;  // scale height
+    float mieScattering = 10.0f;
+    float mieExtinction = 11.1f;
+    float mieHeight = 0.0025f;
+    float mieG = 0.76f;  // Henyey-Greenstein asymmetry
+};
+
+// Precomputed single scattering, after Bruneton and Neyret. Two tables are
+// built from the parameters:
+//
+//   transmittance(r, mu)          to the outer edge, from radius r along a ray
+//                                 whose zenith cosine is mu
+//   scattering(r, mu, mu_s)       light scattered towards r along that ray
+//                                 with the sun at zenith cosine mu_s; Rayleigh
+//                                 in rgb, the red of Mie in a
+//
+// so the planet_atmosphere shaders shade a whole shell with one scattering and
+// two transmittance fetches per fragment instead of marching rays. Without a
+// fourth dimension for the sun's azimuth, the tables place the sun at right
+// angles to the view plane; the phase functions still use the true angle.
+//
+// The tables are built on the thread pool, then stored under directory keyed
+// by a hash of the parameters, so later starts only read them.
+class Atmosphere {
+   public:
+    static const int TRANSMITTANCE_MU = 128;
+    static const int TRANSMITTANCE_R = 32;
+    static const int SCATTERING_MU = 128;
+    static const int SCATTERING_MU_S = 32;
+    static const int SCATTERING_R = 32;
+
+    // Texture units of the tables, shared by every atmosphere program
+    static const GLint TRANSMITTANCE_UNIT = 5;
+    static const GLint SCATTERING_UNIT = 6;
+
+    std::string directory = "atmosphere_cache";
+    // Sun radiance scale, for the 8-bit scene target
+    float intensity = 12.0f;
+
+    explicit Atmosphere(const AtmosphereParameters& parameters = {});
+
+    // Loads the tables from the cache or builds and stores them, then uploads
+    // them. Needs the GL context.
+    void load();
+
+    void begin() { spheres.clear(); }
+    void add(const glm::vec3& center, float planetRadius);
+    // Meant for the premultiplied blend without depth writes, drawn after
+    // opaque geometry. The program must be in use.
+    void render(const Shader& shader, const glm::vec3& sunPosition,
+                const glm::vec3& sunColor);
+
+    const AtmosphereParameters& parameters() const { return params; }
+    bool fromCache() const { return cacheHit; }
+    // Milliseconds load() took
+    float loadTime() const { return loadMilliseconds; }
+    size_t shellCount() const { return spheres.size(); }
+
+    Atmosphere(const Atmosphere&) = delete;
+    Atmosphere& operator=(const Atmosphere&) = delete;
+
+   private:
+    AtmosphereParameters params;
+    bool cacheHit = false;
+    float loadMilliseconds = 0.0f;
+
+    // rgb per texel, mu fastest
+    std::vector<float> transmittance;
+    // rgba per texel, mu fastest, then mu_s, then r
+    std::vector<float> scattering;
+
+    GLuint transmittanceTexture = 0, scatteringTexture = 0;
+
+    std::vector<glm::vec4> spheres;  // centre, planet radius
+    GLuint VAO = 0, quadVBO = 0;
+    StreamBuffer stream{GL_ARRAY_BUFFER, sizeof(glm::vec4)};
+    unsigned int streamGeneration = 0;
+
+    uint64_t key() const;
+    std::string path() const;
+    bool readCache();
+    void writeCache(float buildTime) const;
+
+    void buildTransmittance();
+    void buildScattering();
+    glm::vec3 opticalDepth(float r, float mu) const;
+    glm::vec3 sampleTransmittance(float r, float mu) const;
+
+    void upload();
+    void initQuad();
+};
+
+#endif  // ATMOSPHERE_H
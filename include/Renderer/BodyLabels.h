@@ -0,0 +1,59 @@
+#ifndef BODY_LABELS_H
+#define BODY_LABELS_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct ImDrawList;
+
+// Name and distance labels over the bodies, decluttered in screen space.
+//
+// Each frame the candidates are projected to the screen and bucketed into a
+// grid of label-sized cells, and only the highest-priority candidate of each
+// cell keeps its label. Cells hash to their row-major index and remember the
+// frame they were last claimed in, so nothing is cleared between frames and
+// the pass costs one visit per candidate plus one per survivor.
+class BodyLabels {
+   public:
+    // Pixels; about the size of one label, so survivors rarely overlap
+    float cellWidth = 140.0f;
+    float cellHeight = 28.0f;
+
+    // Starts a frame for a viewport of width x height pixels
+    void begin(const glm::mat4& view, const glm::mat4& projection,
+               const glm::vec3& cameraPos, float width, float height);
+    // name must stay valid until draw(); a non-negative number is appended to
+    // it, so large populations need no strings of their own
+    void add(const glm::vec3& position, float priority, const char* name,
+             int number = -1);
+    // Draws the surviving labels in one pass over the list
+    void draw(ImDrawList* drawList);
+
+    size_t candidateCount() const { return candidates; }
+    size_t labelCount() const { return survivors.size(); }
+
+   private:
+    struct Label {
+        float x, y;
+        float priority;
+        float distance;
+        const char* name;
+        int number;
+    };
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 camera = glm::vec3(0.0f);
+    float width = 0.0f, height = 0.0f;
+    int columns = 0, rows = 0;
+
+    // Per cell: the frame it was last claimed in and its label in survivors
+    std::vector<uint32_t> cellFrame;
+    std::vector<uint32_t> cellLabel;
+    uint32_t frame = 0;
+
+    std::vector<Label> survivors;
+    size_t candidates = 0;
+};
+
+#endif  // BODY_LABELS_H
@@ -0,0 +1,156 @@
+#ifndef BODY_RENDERER_H
+#define BODY_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <map>
+#include <vector>
+
+#include "Camera.h"
+#include "Renderer/Frustum.h"
+#include "Renderer/MeshCache.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Per-instance attributes, read at locations 2-8 by planet.vs
+struct BodyInstance {
+    glm::mat4 model;
+    glm::vec4 color;     // rgb diffuse, a = 1 for emissive (unlit) bodies
+    glm::vec4 material;  // ambient strength, specular strength, shininess, shadow list
+    // x: PlanetSurfaces layer of the first face + 1, 0 for the flat colour
+    glm::vec4 surface = glm::vec4(0.0f);
+};
+
+// Tightly packed point-tier vertex, read at locations 0-1 by point_sprite.vs
+struct PointSprite {
+    glm::vec3 position;
+    float radius;
+    GLuint color;  // RGBA8, a = 255 for emissive bodies
+};
+
+// Collects the bodies submitted during a frame and draws every body that shares
+// a mesh with one glDrawElementsInstanced, so draw calls scale with the number
+// of mesh types instead of the number of bodies.
+//
+// Spheres submitted by centre and radius pick an icosphere LOD from their
+// projected size: the coarsest level whose silhouette error stays under
+// pixelError on screen. LOD 0 is the finest. Below impostorRadius pixels they
+// become camera-facing quads that ray-cast the sphere in the fragment shader,
+// and below pointRadius pixels they are drawn as additive point sprites.
+class BodyRenderer {
+   public:
+    static const unsigned int LOD_COUNT = 5;
+
+    // Largest tolerated deviation from the true sphere, in pixels
+    float pixelError = 0.5f;
+    // Projected radius, in pixels, under which spheres are drawn as impostors
+    float impostorRadius = 16.0f;
+    // Projected radius, in pixels, under which spheres are drawn as points
+    float pointRadius = 1.5f;
+
+    BodyRenderer();
+
+    // Camera and projection used for LOD selection and culling until the next call
+    void setView(const Camera& camera, const glm::mat4& view,
+                 const glm::mat4& projection, float viewportHeight);
+    const Frustum& frustum() const { return viewFrustum; }
+
+    void begin();
+    void submit(const Mesh& mesh, const BodyInstance& instance);
+    void submit(const glm::vec3& center, float radius, const BodyInstance& instance);
+    // Bulk path for large populations of unrotated spheres sharing a colour and
+    // material: spheres are frustum culled and tiered on the thread pool, and
+    // model matrices are only built for the few that are not points
+    void submitSpheres(const glm::vec3* centers, const float* radii, size_t count,
+                       const glm::vec4& color, const glm::vec4& material);
+    // Indices into the last submitSpheres() of the spheres that survived culling
+    // and are drawn larger than a point, in ascending order
+    const std::vector<uint32_t>& resolvedSpheres() const { return resolved; }
+    // Draws with the program in use; the caller sets its uniforms
+    void render();
+    // Call after render(); draw call and triangle counts include every pass.
+    // Impostors reuse BodyInstance, so the program in use takes the same
+    // uniforms as planet.fs
+    void renderImpostors();
+    // Meant for an additive, depth-tested state without depth writes and with
+    // program point size, drawn after opaque geometry. Sets the shader's
+    // pixelScale uniform, the rest are set by the caller.
+    void renderPoints(const Shader& shader);
+
+    // Projected radius of a sphere in pixels, infinite when the camera is inside
+    float screenRadius(const glm::vec3& center, float radius) const;
+    unsigned int selectLod(float screenRadius) const;
+    // Icosphere subdivisions used for a LOD
+    static unsigned int lodSubdivisions(unsigned int lod) { return LOD_COUNT - lod; }
+
+    unsigned int drawCallCount() const { return drawCalls; }
+    size_t instanceCount() const { return instances; }
+    size_t lodInstanceCount(unsigned int lod) const { return lodInstances[lod]; }
+    size_t impostorCount() const { return impostors.instances.size(); }
+    size_t pointCount() const { return points.size(); }
+    size_t culledCount() const { return culled; }
+    size_t triangleCount() const { return triangles; }
+
+   private:
+    struct Batch {
+        GLuint VAO = 0;
+        StreamBuffer stream{GL_ARRAY_BUFFER, sizeof(BodyInstance)};
+        // Stream generation the VAO's instance attributes point into
+        unsigned int streamGeneration = 0;
+        std::vector<BodyInstance> instances;
+    };
+
+    std::map<const Mesh*, Batch> batches;
+    // Instances drawn as a 4-vertex strip from quadVBO instead of a mesh
+    Batch impostors;
+    GLuint quadVBO = 0;
+
+    std::vector<PointSprite> points;
+    GLuint pointVAO = 0;
+    StreamBuffer pointStream{GL_ARRAY_BUFFER, sizeof(PointSprite)};
+    unsigned int pointGeneration = 0;
+
+    // submitSpheres scratch: tier per sphere and point offsets per chunk
+    std::vector<unsigned char> sphereTiers;
+    std::vector<size_t> chunkPoints;
+    std::vector<uint32_t> resolved;
+
+    unsigned int drawCalls = 0;
+    size_t instances = 0;
+    size_t triangles = 0;
+    size_t culled = 0;
+
+    const Mesh* lodMeshes[LOD_COUNT];
+    // Relative (unit sphere) geometric error of each LOD
+    float lodErrors[LOD_COUNT];
+    size_t lodInstances[LOD_COUNT] = {};
+
+    glm::vec3 viewPosition = glm::vec3(0.0f);
+    Frustum viewFrustum;
+    // Pixels per world unit at distance 1
+    float pixelScale = 1.0f;
+
+    enum Tier : unsigned char {
+        TIER_POINT = 0,
+        TIER_IMPOSTOR = 1,
+        TIER_MESH = 2,
+        TIER_CULLED = 3
+    };
+
+    Tier selectTier(float screenRadius) const;
+    void submitInstance(Tier tier, float screenRadius, const BodyInstance& instance);
+
+    void initImpostors();
+    void initPoints();
+    static GLuint packColor(const glm::vec4& color);
+    static void initBatch(const Mesh& mesh, Batch& batch);
+    // 4.5 path: instance attribute formats, sourced from binding 1
+    static void formatInstanceAttributes(GLuint VAO);
+    // Point the arrays at a new stream buffer
+    static void setInstanceAttributes(GLuint VAO, GLuint instanceVBO);
+    static void setPointAttributes(GLuint VAO, GLuint pointVBO);
+    // Returns the instance count uploaded, 0 if the upload failed
+    static GLsizei uploadInstances(Batch& batch);
+};
+
+#endif  // BODY_RENDERER_H
@@ -0,0 +1,98 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Point light as read from the clusterLights buffer texture: two RGBA32F texels
+struct ClusterLight {
+    glm::vec3 position;
+    float range;  // no contribution at or past this distance
+    glm::vec3 color;
+    float shadowed;  // 1 if EclipseShadows' occluder lists were built for it
+};
+
+// Clustered forward lighting. Each frame the view frustum is cut into a grid of
+// froxels, GRID_X x GRID_Y screen tiles by GRID_Z slices spaced logarithmically
+// in depth, and every light is listed in the froxels its range overlaps. Lit
+// shaders look up their fragment's froxel and loop over that list only, so the
+// per-fragment cost follows the lights nearby rather than all of them.
+//
+// Lists are capped at MAX_CLUSTER_LIGHTS; lights are listed in order of
+// decreasing range, so the cap drops the weakest. The lights, the per-froxel
+// (first, count) ranges and the index lists go to buffer textures through
+// stream buffers, and their offsets to the "Clusters" uniform block.
+class ClusteredLights {
+   public:
+    static const unsigned int GRID_X = 16;
+    static const unsigned int GRID_Y = 9;
+    static const unsigned int GRID_Z = 24;
+    static const unsigned int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+    static const unsigned int MAX_CLUSTER_LIGHTS = 64;
+
+    // Binding point of the std140 "Clusters" block and the texture units of
+    // the lists, shared by every lit program
+    static const GLuint BLOCK_BINDING = 1;
+    static const GLint LIGHT_UNIT = 1;
+    static const GLint RANGE_UNIT = 2;
+    static const GLint INDEX_UNIT = 3;
+
+    ClusteredLights();
+
+    void begin() { lights.clear(); }
+    void add(const glm::vec3& position, const glm::vec3& color, float range,
+             bool shadowed = false);
+    // Bins the lights into the froxels of this view and uploads the lists
+    void build(const glm::mat4& view, const glm::mat4& projection, float near,
+               float far, int viewportWidth, int viewportHeight);
+    // Binds the lists to their texture units; call after build()
+    void bind();
+
+    // Points a program's Clusters block and list samplers at the shared slots
+    static void attach(const Shader& shader);
+
+    size_t lightCount() const { return lights.size(); }
+    size_t indexCount() const { return indices.size(); }
+    unsigned int busiestCluster() const { return maxClusterLights; }
+
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+   private:
+    // CPU mirror of the Clusters block
+    struct ClusterData {
+        GLuint grid[4];   // x, y, z froxel counts, light count
+        GLuint bases[4];  // first light, range and index texel of this frame
+        float depth[4];   // near, slices per log unit, tile width, tile height
+    };
+
+    struct Bounds {
+        unsigned int x0, x1, y0, y1, z0, z1;
+        bool visible;
+    };
+
+    std::vector<ClusterLight> lights;
+    std::vector<Bounds> bounds;
+    std::vector<GLuint> ranges;  // first, count per froxel
+    std::vector<GLuint> indices;
+    unsigned int maxClusterLights = 0;
+
+    StreamBuffer lightStream;
+    StreamBuffer rangeStream;
+    StreamBuffer indexStream;
+    StreamBuffer blockStream;
+    GLuint textures[3] = {};
+    unsigned int generations[3] = {};
+
+    Bounds froxelBounds(const ClusterLight& light, const glm::mat4& view,
+                        const glm::mat4& projection, float near,
+                        float sliceScale) const;
+    void upload(StreamBuffer& stream, int list, GLenum format, const void* data,
+                GLsizeiptr bytes);
+};
+
+#endif  // CLUSTERED_LIGHTS_H
@@ -0,0 +1,56 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <glad/glad.h>
+
+// Offscreen target the scene is drawn into at a fraction of the window
+// resolution, then upscaled onto the window so the UI stays native.
+//
+// The fraction follows the GPU time of the scene pass, measured with timer
+// queries read back a few frames late so they never stall, towards
+// targetTime. Pixel cost goes with area, so the linear scale moves with the
+// square root of the budget ratio, applied to the scale the measured frame was
+// drawn at. The scale only moves when a new measurement arrives. The target is
+// allocated at full size and the scene uses its lower-left corner, so scale
+// changes never reallocate.
+class DynamicResolution {
+   public:
+    // Frames of timer queries in flight
+    static const int QUERY_COUNT = 4;
+
+    bool enabled = true;
+    float targetTime = 12.0f;  // milliseconds of GPU time for the scene pass
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // Where end() puts the upscaled scene; the window unless rendering headless
+    GLuint outputFramebuffer = 0;
+
+    // Matches the target to the window's framebuffer; cheap when unchanged
+    void resize(int width, int height);
+    // Redirects drawing into the target at the current scale
+    void begin();
+    // Upscales the scene onto the default framebuffer and adapts the scale
+    void end();
+
+    float scale() const { return currentScale; }
+    int sceneWidth() const { return scaled(width); }
+    int sceneHeight() const { return scaled(height); }
+    // Last measured GPU time of the scene pass in milliseconds, 0 if unknown
+    float gpuTime() const { return measuredTime; }
+
+   private:
+    GLuint FBO = 0, colorBuffer = 0, depthBuffer = 0;
+    int width = 0, height = 0;
+    float currentScale = 1.0f;
+
+    GLuint queries[QUERY_COUNT] = {};
+    // Scale each query's frame was drawn at
+    float queryScales[QUERY_COUNT] = {};
+    unsigned long frames = 0;
+    float measuredTime = 0.0f;
+
+    int scaled(int size) const;
+    void adapt(float time, float issuedScale);
+};
+
+#endif  // DYNAMIC_RESOLUTION_H
@@ -0,0 +1,71 @@
+#ifndef ECLIPSE_SHADOWS_H
+#define ECLIPSE_SHADOWS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Shadows of spherical bodies cast by the light's disc, evaluated analytically
+// in the lit shaders: the fraction of the star's disc left uncovered by each
+// occluder gives umbra, penumbra and annular eclipses with no shadow maps.
+//
+// The CPU gives every receiving body a short list of the occluders that can
+// lie between it and the light, those touching the convex hull of the light
+// and receiver spheres, keeping the MAX_OCCLUDERS largest as seen from the
+// receiver. Lists have a fixed size, so a fragment tests at most that many
+// spheres however crowded the system.
+class EclipseShadows {
+   public:
+    static const int MAX_OCCLUDERS = 4;
+    // Texture unit of the occluder buffer texture, shared by every lit program
+    static const GLint OCCLUDER_UNIT = 4;
+
+    EclipseShadows();
+
+    void begin(const glm::vec3& lightPosition, float lightRadius);
+    // Returns the occluder's index, to exclude it from its own list
+    int addOccluder(const glm::vec3& center, float radius);
+    // Builds the list of a receiver once every occluder has been added. The
+    // result goes in BodyInstance::material.w: 0 when nothing can shadow the
+    // receiver, otherwise its list number plus one.
+    float addReceiver(const glm::vec3& center, float radius, int self = -1);
+    void upload();
+    // Binds the lists and sets the program's occluderBase; the program must be
+    // in use
+    void bind(const Shader& shader) const;
+
+    // Points a program's occluder sampler at OCCLUDER_UNIT
+    static void attach(const Shader& shader);
+
+    size_t occluderCount() const { return occluders.size(); }
+    size_t listCount() const { return lists.size() / MAX_OCCLUDERS; }
+    // Occluders that passed the hull test over all lists, before the cap
+    size_t candidateCount() const { return candidates; }
+
+    EclipseShadows(const EclipseShadows&) = delete;
+    EclipseShadows& operator=(const EclipseShadows&) = delete;
+
+   private:
+    struct Candidate {
+        float size;  // angular radius seen from the receiver's surface
+        int occluder;
+    };
+
+    glm::vec3 light = glm::vec3(0.0f);
+    float lightRadius = 0.0f;
+
+    std::vector<glm::vec4> occluders;  // centre, radius
+    // MAX_OCCLUDERS spheres per list, radius 0 past the end
+    std::vector<glm::vec4> lists;
+    std::vector<Candidate> scratch;
+    size_t candidates = 0;
+
+    StreamBuffer stream;
+    GLuint texture = 0;
+    unsigned int generation = 0;
+};
+
+#endif  // ECLIPSE_SHADOWS_H
@@ -0,0 +1,70 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/glad.h>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Records rendered frames as raw top-down RGBA8 video.
+//
+// Each capture() queues an asynchronous glReadPixels into the next pixel pack
+// buffer of a ring and fences it. Before that, the readback queued in the same
+// buffer RING frames earlier, long finished by then, is copied out, so the GPU
+// is never drained to read a frame. Copies go to a writer thread, which flips
+// rows and writes them out; the render thread only waits when the writer falls
+// MAX_QUEUED frames behind, so no frame is dropped.
+//
+// A destination starting with '|' is run as a command that reads the frames
+// on its standard input, e.g. ffmpeg with -f rawvideo -pix_fmt rgba.
+class FrameCapture {
+   public:
+    static const int RING = 3;
+    static const size_t MAX_QUEUED = 8;
+
+    ~FrameCapture();
+
+    // Reads from framebuffer, 0 being the window's back buffer. Returns false
+    // if the destination could not be opened.
+    bool open(const std::string& destination, GLuint framebuffer, int width,
+              int height);
+    // Drains pending readbacks, then waits for the writer to finish. Needs the
+    // context, so call it before the context goes away.
+    void close();
+    bool isOpen() const { return output != nullptr; }
+
+    // Queues the frame just drawn into the framebuffer
+    void capture();
+
+    unsigned long framesWritten() const;
+
+   private:
+    GLuint source = 0;
+    int width = 0, height = 0;
+    size_t frameBytes = 0;
+
+    GLuint PBOs[RING] = {};
+    GLsync fences[RING] = {};
+    unsigned long captured = 0;
+
+    FILE* output = nullptr;
+    bool pipe = false;
+    std::thread writer;
+    mutable std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable drained;
+    std::deque<std::vector<unsigned char>> queue;
+    std::vector<std::vector<unsigned char>> spare;
+    unsigned long written = 0;
+    bool closing = false;
+
+    // Copies a finished readback out of the ring and hands it to the writer
+    void collect(int slot);
+    void writeLoop();
+};
+
+#endif  // FRAME_CAPTURE_H
@@ -0,0 +1,44 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Renderer/StreamBuffer.h"
+
+// CPU mirror of the std140 "Frame" block in assets/shaders/frame.glsl. Every vec3 is
+// followed by a float so the C++ layout matches std140 without extra padding.
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 cameraPos;
+    float time;
+    glm::vec3 lightPosition;
+    float padding0;
+    glm::vec3 lightAmbient;
+    float padding1;
+    glm::vec3 lightDiffuse;
+    float padding2;
+    glm::vec3 lightSpecular;
+    // 1 / log2(far + 1): scales log2(1 + w) to [0, 1] over the view range in
+    // programs built with LOG_DEPTH
+    float logDepth;
+};
+
+// Camera and light state shared by every program through one uniform buffer,
+// uploaded once per frame instead of set on each shader. Each upload goes to a
+// new stream region, which is then bound as the Frame block's range.
+class FrameUniforms {
+   public:
+    FrameUniforms();
+
+    void upload(const FrameData& data);
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+   private:
+    StreamBuffer stream;
+};
+
+#endif  // FRAME_UNIFORMS_H
@@ -0,0 +1,48 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes extracted from a view-projection
+// matrix (Gribb-Hartmann), normalised so plane distances are in world units.
+class Frustum {
+   public:
+    enum Containment { OUTSIDE = 0, INTERSECTS = 1, INSIDE = 2 };
+
+    Frustum() {}
+    explicit Frustum(const glm::mat4& viewProjection) {
+        // glm is column-major: row i of the matrix is (m[0][i], ..., m[3][i])
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i],
+                                viewProjection[2][i], viewProjection[3][i]);
+
+        planes[0] = rows[3] + rows[0];  // left
+        planes[1] = rows[3] - rows[0];  // right
+        planes[2] = rows[3] + rows[1];  // bottom
+        planes[3] = rows[3] - rows[1];  // top
+        planes[4] = rows[3] + rows[2];  // near
+        planes[5] = rows[3] - rows[2];  // far
+
+        for (auto& plane : planes) plane /= glm::length(glm::vec3(plane));
+    }
+
+    Containment classify(const glm::vec3& center, float radius) const {
+        Containment result = INSIDE;
+        for (const auto& plane : planes) {
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+            if (distance < -radius) return OUTSIDE;
+            if (distance < radius) result = INTERSECTS;
+        }
+        return result;
+    }
+
+    bool intersects(const glm::vec3& center, float radius) const {
+        return classify(center, radius) != OUTSIDE;
+    }
+
+   private:
+    glm::vec4 planes[6];
+};
+
+#endif  // FRUSTUM_H
@@ -0,0 +1,113 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/glad.h>
+
+// The GL 4.x entry points used by the persistent-mapping backend, direct
+// state access vertex arrays and the program binary cache. glad is generated
+// for 3.3 core, so these are loaded by hand after it.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void(APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize,
+                                                   GLsizei* length,
+                                                   GLenum* binaryFormat,
+                                                   void* binary);
+typedef void(APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat,
+                                                const void* binary, GLsizei length);
+typedef void(APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname,
+                                                    GLint value);
+typedef void(APIENTRYP PFNGLCREATEBUFFERSPROC)(GLsizei n, GLuint* buffers);
+typedef void(APIENTRYP PFNGLNAMEDBUFFERSTORAGEPROC)(GLuint buffer, GLsizeiptr size,
+                                                     const void* data,
+                                                     GLbitfield flags);
+typedef void(APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC)(GLuint buffer, GLintptr offset,
+                                                     GLsizeiptr size,
+                                                     const void* data);
+typedef void*(APIENTRYP PFNGLMAPNAMEDBUFFERRANGEPROC)(GLuint buffer, GLintptr offset,
+                                                       GLsizeiptr length,
+                                                       GLbitfield access);
+typedef GLboolean(APIENTRYP PFNGLUNMAPNAMEDBUFFERPROC)(GLuint buffer);
+typedef void(APIENTRYP PFNGLCREATEVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+typedef void(APIENTRYP PFNGLVERTEXARRAYVERTEXBUFFERPROC)(GLuint vaobj,
+                                                          GLuint bindingindex,
+                                                          GLuint buffer,
+                                                          GLintptr offset,
+                                                          GLsizei stride);
+typedef void(APIENTRYP PFNGLVERTEXARRAYELEMENTBUFFERPROC)(GLuint vaobj,
+                                                           GLuint buffer);
+typedef void(APIENTRYP PFNGLVERTEXARRAYATTRIBFORMATPROC)(GLuint vaobj,
+                                                          GLuint attribindex,
+                                                          GLint size, GLenum type,
+                                                          GLboolean normalized,
+                                                          GLuint relativeoffset);
+typedef void(APIENTRYP PFNGLVERTEXARRAYATTRIBBINDINGPROC)(GLuint vaobj,
+                                                           GLuint attribindex,
+                                                           GLuint bindingindex);
+typedef void(APIENTRYP PFNGLENABLEVERTEXARRAYATTRIBPROC)(GLuint vaobj, GLuint index);
+typedef void(APIENTRYP PFNGLVERTEXARRAYBINDINGDIVISORPROC)(GLuint vaobj,
+                                                            GLuint bindingindex,
+                                                            GLuint divisor);
+typedef void(APIENTRYP PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC)(
+    GLenum mode, GLint first, GLsizei count, GLsizei instancecount,
+    GLuint baseinstance);
+typedef void(APIENTRYP PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC)(
+    GLenum mode, GLsizei count, GLenum type, const void* indices,
+    GLsizei instancecount, GLuint baseinstance);
+
+namespace GLExt {
+
+// Loads the entry points when the current context is 4.5 or newer and
+// allowed is set. Returns whether the 4.5 path is usable; on false every
+// caller keeps to 3.3 core.
+bool load(GLADloadproc loader, bool allowed = true);
+bool directStateAccess();
+// Program binaries (4.1 or ARB_get_program_binary) with at least one format,
+// checked by load() whatever the 4.5 outcome
+bool programBinary();
+
+// 4.5 path: formats attribute index of vao, sources it from binding and
+// enables it. Buffers are attached to bindings separately, so re-pointing an
+// array at a new stream buffer is a single VertexArrayVertexBuffer.
+void vertexAttribute(GLuint vao, GLuint index, GLuint binding, GLint size,
+                     GLenum type, GLboolean normalized, GLuint offset);
+
+extern PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC ProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+
+extern PFNGLCREATEBUFFERSPROC CreateBuffers;
+extern PFNGLNAMEDBUFFERSTORAGEPROC NamedBufferStorage;
+extern PFNGLNAMEDBUFFERSUBDATAPROC NamedBufferSubData;
+extern PFNGLMAPNAMEDBUFFERRANGEPROC MapNamedBufferRange;
+extern PFNGLUNMAPNAMEDBUFFERPROC UnmapNamedBuffer;
+extern PFNGLCREATEVERTEXARRAYSPROC CreateVertexArrays;
+extern PFNGLVERTEXARRAYVERTEXBUFFERPROC VertexArrayVertexBuffer;
+extern PFNGLVERTEXARRAYELEMENTBUFFERPROC VertexArrayElementBuffer;
+extern PFNGLVERTEXARRAYATTRIBFORMATPROC VertexArrayAttribFormat;
+extern PFNGLVERTEXARRAYATTRIBBINDINGPROC VertexArrayAttribBinding;
+extern PFNGLENABLEVERTEXARRAYATTRIBPROC EnableVertexArrayAttrib;
+extern PFNGLVERTEXARRAYBINDINGDIVISORPROC VertexArrayBindingDivisor;
+extern PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC DrawArraysInstancedBaseInstance;
+extern PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC DrawElementsInstancedBaseInstance;
+
+}  // namespace GLExt
+
+#endif  // GL_EXT_H
@@ -0,0 +1,90 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+// Fixed-function state a draw depends on. Applied through GLState, so only the
+// parts that differ from the previous draw reach the driver.
+struct RenderState {
+    // BLEND_PREMULTIPLIED adds the source and keeps 1 - alpha of the destination
+    enum Blend : unsigned char {
+        BLEND_NONE = 0,
+        BLEND_ALPHA = 1,
+        BLEND_ADDITIVE = 2,
+        BLEND_PREMULTIPLIED = 3
+    };
+
+    bool depthTest = true;
+    bool depthWrite = true;
+    Blend blend = BLEND_NONE;
+    bool programPointSize = false;
+
+    // Small integer identifying the combination, for sort keys
+    unsigned int key() const {
+        return (depthTest ? 1u : 0u) | (depthWrite ? 2u : 0u) | (blend << 2) |
+               (programPointSize ? 16u : 0u);
+    }
+};
+
+// Shadow copy of the GL state touched by the renderer. Every bind and toggle
+// goes through here and is dropped when it would not change anything.
+//
+// All program and vertex array binds must use this class, or the shadow goes
+// stale; call invalidate() after code that changes state behind its back.
+// (The ImGui backend restores what it changes, so it needs no invalidate.)
+class GLState {
+   public:
+    static GLState& get() {
+        static GLState instance;
+        return instance;
+    }
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void setCapability(GLenum capability, bool enabled);
+    void blendFunc(GLenum source, GLenum destination);
+    void depthMask(bool write);
+    void polygonMode(GLenum mode);
+    void lineWidth(GLfloat width);
+    void pointSize(GLfloat size);
+
+    void apply(const RenderState& state);
+
+    // Forget everything, so the next call of each kind is always issued
+    void invalidate();
+
+    unsigned int issuedCount() const { return issued; }
+    unsigned int skippedCount() const { return skipped; }
+    void resetCounters() { issued = skipped = 0; }
+
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+
+   private:
+    GLState() { invalidate(); }
+
+    static const int CAPABILITY_COUNT = 4;
+    static const GLenum CAPABILITIES[CAPABILITY_COUNT];
+
+    // -1 unknown, otherwise the value last issued
+    long long program, vao;
+    int capabilities[CAPABILITY_COUNT];
+    long long blendSource, blendDestination;
+    int depthWrite;
+    long long polygon;
+    GLfloat line, point;
+
+    unsigned int issued = 0;
+    unsigned int skipped = 0;
+
+    // Counts the call and reports whether it has to be issued
+    bool change(bool differs) {
+        if (differs)
+            issued++;
+        else
+            skipped++;
+        return differs;
+    }
+};
+
+#endif  // GL_STATE_H
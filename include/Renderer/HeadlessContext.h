@@ -0,0 +1,34 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <glad/glad.h>
+
+// An OpenGL context with no window or display, for rendering on machines
+// without one. Created through EGL on a surfaceless display, which Mesa serves
+// with llvmpipe when there is no GPU. Only available when the build found EGL
+// (PLANET_SIM_EGL); create() fails otherwise.
+//
+// There is no default framebuffer, so frames are drawn into framebuffer().
+class HeadlessContext {
+   public:
+    ~HeadlessContext();
+
+    // Makes a 4.5 core context current, or a 3.3 one when that fails or
+    // allowGL45 is false
+    bool create(bool allowGL45);
+    void destroy();
+
+    // Stands in for the default framebuffer; needs GL loaded
+    void createFramebuffer(int width, int height);
+    GLuint framebuffer() const { return FBO; }
+
+    // For gladLoadGLLoader and GLExt::load
+    static void* loadProc(const char* name);
+
+   private:
+    void* display = nullptr;
+    void* context = nullptr;
+    GLuint FBO = 0, colorBuffer = 0;
+};
+
+#endif  // HEADLESS_CONTEXT_H
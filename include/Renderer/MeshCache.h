@@ -0,0 +1,38 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <glad/glad.h>
+#include <map>
+
+#include "utils/Geometry.h"
+
+// GPU buffers of a unit-radius mesh with interleaved position and normal, three
+// floats each. Users point their own vertex arrays at them.
+struct Mesh {
+    GLuint VBO = 0, EBO = 0;
+    GLsizei indexCount = 0;
+};
+
+// Builds each tessellation once and hands the same buffers to every body that
+// asks for it. References stay valid for the lifetime of the program.
+class MeshCache {
+   public:
+    static MeshCache& get() {
+        static MeshCache instance;
+        return instance;
+    }
+
+    const Mesh& icosphere(unsigned int subdivisions);
+
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+   private:
+    MeshCache() {}
+
+    std::map<unsigned int, Mesh> icospheres;
+
+    static Mesh upload(const Geometry::GeometryData& data);
+};
+
+#endif  // MESH_CACHE_H
@@ -0,0 +1,65 @@
+#ifndef PLANET_SURFACES_H
+#define PLANET_SURFACES_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Renderer/Shader.h"
+
+// Procedural planet surfaces: per seed, a colour and a normal cube map of
+// fractal noise terrain. The faces of every surface are layers of two 2D array
+// textures, so one instanced draw can show planets with different surfaces;
+// the shaders pick the face and coordinates from the direction themselves, in
+// GL cube map order and orientation.
+//
+// Surfaces are generated on the thread pool, one face row per job, and stored
+// compressed under directory keyed by seed and resolution, so later starts
+// only read and inflate them. Without zlib the cache is stored uncompressed.
+class PlanetSurfaces {
+   public:
+    static const int FACES = 6;
+    // Texture units of the colour and normal arrays, shared by every lit program
+    static const GLint COLOR_UNIT = 7;
+    static const GLint NORMAL_UNIT = 8;
+
+    std::string directory = "surface_cache";
+    // Texels per face edge; takes effect at the next build()
+    int resolution = 256;
+
+    // Registers a surface and returns the value for Body::surfaceLayer
+    float add(uint32_t seed);
+    // Generates or loads every surface added, then uploads them. Needs the GL
+    // context.
+    void build();
+    void bind() const;
+
+    // Points a program's surface samplers at the shared units
+    static void attach(const Shader& shader);
+
+    size_t size() const { return seeds.size(); }
+    unsigned int cachedCount() const { return cached; }
+    // Milliseconds build() took
+    float buildTime() const { return buildMilliseconds; }
+
+   private:
+    // RGBA8 per texel, face-major: albedo and specular strength, and the
+    // object-space normal mapped to [0, 1]
+    struct Surface {
+        std::vector<uint8_t> color;
+        std::vector<uint8_t> normal;
+    };
+
+    std::vector<uint32_t> seeds;
+    GLuint colorArray = 0, normalArray = 0;
+    unsigned int cached = 0;
+    float buildMilliseconds = 0.0f;
+
+    std::string path(uint32_t seed) const;
+    bool readCache(uint32_t seed, Surface& surface) const;
+    void writeCache(uint32_t seed, const Surface& surface) const;
+    void generate(uint32_t seed, Surface& surface) const;
+};
+
+#endif  // PLANET_SURFACES_H
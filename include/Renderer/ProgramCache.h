@@ -0,0 +1,54 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+// On-disk cache of linked program binaries, so later starts skip compiling and
+// linking. An entry is keyed by a hash of the shader sources and of the driver
+// (vendor, renderer and version strings): editing a shader or updating the
+// driver makes the old entry miss, and the program is compiled again and its
+// new binary stored. Drivers may still reject a binary, which is a miss too.
+//
+// Entries remember how long their program took to build, so hits can report
+// the startup time they saved.
+class ProgramCache {
+   public:
+    static ProgramCache& get() {
+        static ProgramCache instance;
+        return instance;
+    }
+
+    std::string directory = "shader_cache";
+
+    // Key of a program built from these sources on the current context
+    uint64_t key(const std::string& vertex, const std::string& fragment) const;
+
+    // Loads the cached binary into program; true if it is linked and usable
+    bool load(GLuint program, uint64_t key);
+    // Stores the binary of a program linked with the retrievable hint, along
+    // with the milliseconds it took to build
+    void store(GLuint program, uint64_t key, float buildTime);
+
+    unsigned int hitCount() const { return hits; }
+    unsigned int missCount() const { return misses; }
+    // Total build time of the programs that were loaded instead
+    float savedTime() const { return saved; }
+    // Time spent creating programs, cached or not
+    float totalTime() const { return total; }
+    void addTime(float milliseconds) { total += milliseconds; }
+
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+   private:
+    ProgramCache() {}
+
+    unsigned int hits = 0, misses = 0;
+    float saved = 0.0f, total = 0.0f;
+
+    std::string path(uint64_t key) const;
+};
+
+#endif  // PROGRAM_CACHE_H
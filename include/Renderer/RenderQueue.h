@@ -0,0 +1,43 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Renderer/GLState.h"
+#include "Renderer/Shader.h"
+
+// Collects the frame's draws and submits them sorted so consecutive draws share
+// as much state as possible. The 64-bit key orders by
+//
+//   layer | program | vertex array | render state | depth
+//
+// where the layer is the blend mode: opaque draws come first, front to back,
+// then alpha-blended draws, then additive ones, then premultiplied ones that
+// dim what is behind them. Blended layers put depth (back to front) ahead of
+// the program, since their order is visible.
+class RenderQueue {
+   public:
+    // vao is only a sort hint (0 when unknown); the draw binds what it needs
+    void submit(const Shader& shader, GLuint vao, const RenderState& state,
+                float depth, std::function<void()> draw);
+
+    // Sorts, draws and clears the queue
+    void flush();
+
+    size_t itemCount() const { return lastItemCount; }
+
+   private:
+    struct Item {
+        uint64_t key;
+        const Shader* shader;
+        RenderState state;
+        std::function<void()> draw;
+    };
+
+    std::vector<Item> items;
+    size_t lastItemCount = 0;
+};
+
+#endif  // RENDER_QUEUE_H
@@ -6,123 +6,255 @@
 #include <glm/fwd.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <cmath>
+#include <unordered_map>
+
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
+#include "Renderer/ProgramCache.h"
+
+// Typed uniform location, resolved once through Shader::uniform<T>() and then set
+// without any string lookup
+template <typename T>
+struct Uniform {
+    GLint location = -1;
+    bool valid() const { return location >= 0; }
+};
 
 class Shader {
    public:
+    // Binding point of the std140 "Frame" uniform block, see FrameUniforms
+    static const GLuint FRAME_BLOCK_BINDING = 0;
+
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly, or loads the program binary
+    // a previous run cached for the same sources and driver. defines are
+    // #define lines placed after each stage's #version, selecting a variant.
     // ------------------------------------------------------------------------
-    Shader(const char *vertexPath, const char *fragmentPath) {
-        // 1. retrieve the vertex/fragment source code from filePath
+    Shader(const char *vertexPath, const char *fragmentPath,
+           const std::string &defines = "") {
+        auto start = std::chrono::steady_clock::now();
+        // 1. retrieve the vertex/fragment source code from filePath, with
+        // includes expanded so the cache key covers them too
         std::string vertexCode;
         std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        } catch (std::ifstream::failure &e) {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what()
-                      << std::endl;
-        }
-        const char *vShaderCode = vertexCode.c_str();
-        const char *fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, nullptr);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, nullptr);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
+        readSource(vertexPath, vertexCode);
+        readSource(fragmentPath, fragmentCode);
+        addDefines(vertexCode, defines);
+        addDefines(fragmentCode, defines);
         ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer
-        // necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        uint64_t cacheKey = ProgramCache::get().key(vertexCode, fragmentCode);
+        if (!ProgramCache::get().load(ID, cacheKey))
+            build(vertexCode, fragmentCode, cacheKey);
+        ProgramCache::get().addTime(millisecondsSince(start));
+
+        cacheUniforms();
     }
     // activate the shader
     // ------------------------------------------------------------------------
-    void use() const { glUseProgram(ID); }
+    void use() const { GLState::get().useProgram(ID); }
+    // uniform locations, cached at link time; -1 for names the program lacks
+    // ------------------------------------------------------------------------
+    GLint location(const std::string &name) const {
+        auto found = uniformLocations.find(name);
+        return found != uniformLocations.end() ? found->second : -1;
+    }
+    template <typename T>
+    Uniform<T> uniform(const std::string &name) const {
+        Uniform<T> handle;
+        handle.location = location(name);
+        return handle;
+    }
+    // typed setters, the program must be in use
+    // ------------------------------------------------------------------------
+    void set(Uniform<bool> u, bool value) const { glUniform1i(u.location, (int)value); }
+    void set(Uniform<int> u, int value) const { glUniform1i(u.location, value); }
+    void set(Uniform<float> u, float value) const { glUniform1f(u.location, value); }
+    void set(Uniform<glm::vec2> u, const glm::vec2 &value) const {
+        glUniform2fv(u.location, 1, glm::value_ptr(value));
+    }
+    void set(Uniform<glm::vec3> u, const glm::vec3 &value) const {
+        glUniform3fv(u.location, 1, glm::value_ptr(value));
+    }
+    void set(Uniform<glm::vec4> u, const glm::vec4 &value) const {
+        glUniform4fv(u.location, 1, glm::value_ptr(value));
+    }
+    void set(Uniform<glm::mat3> u, const glm::mat3 &mat) const {
+        glUniformMatrix3fv(u.location, 1, GL_FALSE, glm::value_ptr(mat));
+    }
+    void set(Uniform<glm::mat4> u, const glm::mat4 &mat) const {
+        glUniformMatrix4fv(u.location, 1, GL_FALSE, glm::value_ptr(mat));
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(name), value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+        glUniform2fv(location(name), 1, glm::value_ptr(value));
     }
     void setVec2(const std::string &name, float x, float y) const {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(location(name), x, y);
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+        glUniform3fv(location(name), 1, glm::value_ptr(value));
     }
     void setVec3(const std::string &name, float x, float y, float z) const {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(location(name), x, y, z);
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+        glUniform4fv(location(name), 1, glm::value_ptr(value));
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) const {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(location(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                           glm::value_ptr(mat));
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                           glm::value_ptr(mat));
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                           glm::value_ptr(mat));
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, glm::value_ptr(mat));
     }
 
    private:
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    // Inserts defines after the #version line, which must stay first
+    // ------------------------------------------------------------------------
+    static void addDefines(std::string &code, const std::string &defines) {
+        if (defines.empty()) return;
+        size_t version = code.find("#version");
+        size_t end = version == std::string::npos ? 0 : code.find('\n', version);
+        if (end == std::string::npos) return;
+        code.insert(version == std::string::npos ? 0 : end + 1, defines);
+    }
+    // Appends a shader file to code, replacing each line of the form
+    // #include "name" with that file, named relative to the including one
+    // ------------------------------------------------------------------------
+    static bool readSource(const std::string &path, std::string &code,
+                           int depth = 0) {
+        if (depth > 8) {
+            std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP: " << path << std::endl;
+            return false;
+        }
+        std::ifstream file(path);
+        if (!file) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path
+                      << std::endl;
+            return false;
+        }
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t open = line.find('"');
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (line.compare(0, 8, "#include") == 0 && close != std::string::npos) {
+                std::string name = line.substr(open + 1, close - open - 1);
+                if (!readSource(directory + name, code, depth + 1)) return false;
+                continue;
+            }
+            code += line;
+            code += '\n';
+        }
+        return true;
+    }
+
+    static float millisecondsSince(std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<float, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+    // Compiles and links into ID, then stores the binary for the next start
+    // ------------------------------------------------------------------------
+    void build(const std::string &vertexCode, const std::string &fragmentCode,
+               uint64_t cacheKey) {
+        auto start = std::chrono::steady_clock::now();
+        const char *vShaderCode = vertexCode.c_str();
+        const char *fShaderCode = fragmentCode.c_str();
+        // 2. compile shaders
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, nullptr);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, nullptr);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+        // shader Program, which may already hold a rejected binary
+        if (GLExt::programBinary())
+            GLExt::ProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer
+        // necessary
+        glDetachShader(ID, vertex);
+        glDetachShader(ID, fragment);
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE)
+            ProgramCache::get().store(ID, cacheKey, millisecondsSince(start));
+    }
+
+    // Resolves every active uniform once, and attaches the Frame block (if the
+    // program declares one) to its shared binding point
+    // ------------------------------------------------------------------------
+    void cacheUniforms() {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++) {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(ID, i, maxLength, &length, &size, &type, &name[0]);
+            std::string uniformName = name.substr(0, length);
+
+            // Block members have no location
+            GLint uniformLocation = glGetUniformLocation(ID, uniformName.c_str());
+            if (uniformLocation < 0) continue;
+            uniformLocations[uniformName] = uniformLocation;
+
+            // Arrays are reported as "name[0]"; make "name" work as well
+            size_t bracket = uniformName.find("[0]");
+            if (bracket != std::string::npos)
+                uniformLocations[uniformName.substr(0, bracket)] = uniformLocation;
+        }
+
+        GLuint frameBlock = glGetUniformBlockIndex(ID, "Frame");
+        if (frameBlock != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, frameBlock, FRAME_BLOCK_BINDING);
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type) {
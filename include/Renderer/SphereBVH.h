@@ -0,0 +1,63 @@
+#ifndef SPHERE_BVH_H
+#define SPHERE_BVH_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+#include "Renderer/Frustum.h"
+
+// Bounding volume hierarchy over spheres, for frustum culling of bodies.
+//
+// The topology is built once by median splits and then refit every frame from
+// the current positions, which is much cheaper than a rebuild and stays tight
+// as long as primitives keep roughly the same neighbours. needsRebuild() says
+// when they have drifted apart enough to be worth a fresh build.
+//
+// Nodes are stored depth first, so every subtree covers a contiguous range of
+// order(). Culling reports those ranges rather than single primitives, and a
+// subtree entirely inside the frustum costs one range without further tests.
+class SphereBVH {
+   public:
+    // [first, first + count) into order()
+    typedef std::pair<uint32_t, uint32_t> Range;
+
+    void build(const glm::vec3* centers, const float* radii, size_t count,
+               unsigned int leafSize = 4);
+    void refit(const glm::vec3* centers, const float* radii);
+
+    // Once leaves have grown to twice their built size, refitting stops paying off
+    bool needsRebuild() const { return leafRadiusSum > 2.0f * builtLeafRadiusSum; }
+
+    // Appends the visible ranges, merging neighbours, and returns the number of
+    // primitives they cover
+    size_t cull(const Frustum& frustum, std::vector<Range>& ranges) const;
+    // Same, expanded to primitive indices
+    size_t cull(const Frustum& frustum, std::vector<uint32_t>& indices) const;
+
+    // Primitive index at each position of the depth-first leaf order
+    const std::vector<uint32_t>& order() const { return primitiveOrder; }
+    size_t size() const { return primitiveOrder.size(); }
+    size_t nodeCount() const { return nodes.size(); }
+
+   private:
+    struct Node {
+        glm::vec3 center;
+        float radius;
+        uint32_t first, count;  // primitive range of the whole subtree
+        uint32_t right;         // right child; 0 for leaves, left child is next
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> primitiveOrder;
+    std::vector<uint32_t> leaves;
+    unsigned int leafSize = 4;
+    float leafRadiusSum = 0.0f;
+    float builtLeafRadiusSum = 0.0f;
+
+    uint32_t buildNode(const glm::vec3* centers, uint32_t first, uint32_t count);
+    void fitLeaf(Node& node, const glm::vec3* centers, const float* radii) const;
+};
+
+#endif  // SPHERE_BVH_H
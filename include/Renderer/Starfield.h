@@ -0,0 +1,80 @@
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+
+#include "Renderer/Shader.h"
+
+// Packed star record, as stored in the cache and read at locations 0-1 by
+// starfield.vs
+struct CatalogStar {
+    float direction[3];  // unit vector on the celestial sphere
+    float magnitude;     // apparent visual magnitude
+    uint32_t color;      // RGBA8 from the colour index
+};
+
+// Background sky drawn from a star catalog as point sprites at infinity.
+//
+// The catalog is a text file with one star per line: right ascension and
+// declination in degrees, visual magnitude and an optional B-V colour index,
+// separated by spaces or commas; '#' starts a comment. The first load sorts the
+// stars by magnitude, cuts them into one-magnitude tiers and writes the packed
+// records to cachePath. Later loads read that file straight into the vertex
+// buffer, and only parse the text again when the catalog's size or time
+// changes.
+//
+// Since tiers are contiguous and sorted, a frame draws the tiers brighter than
+// limitingMagnitude() with one call each and never touches the rest. Like a
+// camera, the limit follows the exposure: it is the magnitude whose light falls
+// to a twentieth of a pixel, so a longer exposure reveals fainter stars.
+class Starfield {
+   public:
+    // Tier t holds magnitudes in [t + FIRST_MAGNITUDE, t + FIRST_MAGNITUDE + 1);
+    // the first and last tiers are open-ended
+    static const int TIER_COUNT = 24;
+    static const int FIRST_MAGNITUDE = -2;
+
+    std::string cachePath = "star_cache.bin";
+
+    // Limiting magnitude at an exposure of one, about that of the naked eye
+    static constexpr float REFERENCE_MAGNITUDE = 6.5f;
+
+    // Scales the light of every star
+    float exposure = 1.0f;
+
+    // Faintest magnitude drawn at the current exposure
+    float limitingMagnitude() const;
+
+    // Loads the catalog through the cache; false if neither could be read
+    bool load(const std::string& catalogPath);
+    // Meant for an additive, depth-tested state without depth writes and with
+    // program point size. Sets every uniform starfield.vs takes but the Frame
+    // block.
+    void render(const Shader& shader, float maxPointSize);
+
+    bool loaded() const { return starCount > 0; }
+    bool fromCache() const { return cacheHit; }
+    // Milliseconds load() took
+    float loadTime() const { return loadMilliseconds; }
+    size_t size() const { return starCount; }
+    // Of the last render()
+    unsigned int drawCallCount() const { return drawCalls; }
+    size_t drawnCount() const { return drawnStars; }
+
+   private:
+    GLuint VAO = 0, VBO = 0;
+    size_t starCount = 0;
+    // Record index of each tier's first star; tierFirst[TIER_COUNT] = size()
+    uint32_t tierFirst[TIER_COUNT + 1] = {};
+    bool cacheHit = false;
+    float loadMilliseconds = 0.0f;
+
+    unsigned int drawCalls = 0;
+    size_t drawnStars = 0;
+
+    void upload(const CatalogStar* stars, size_t count);
+};
+
+#endif  // STARFIELD_H
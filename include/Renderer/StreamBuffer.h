@@ -0,0 +1,62 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+// A buffer rewritten by the CPU every time it is used, such as per-frame
+// instance data or geometry rebuilt on the CPU.
+//
+// With the 4.5 backend the storage is immutable and persistently mapped, split
+// into REGIONS regions written in turn. Moving on to a region places a fence
+// behind every draw issued so far, and writing a region first waits on the
+// fence placed when it was last left, so the CPU never overwrites data the GPU
+// has yet to read and the driver never reallocates or synchronises implicitly.
+// Without it, each map() orphans the storage and maps it from the start.
+//
+// Draws must source from offset(), or first() in units of the stride, and
+// vertex arrays must be re-pointed whenever generation() changes.
+//
+// Owns its buffer and fences, so it moves but does not copy. Must be destroyed
+// while the context that created it is still current.
+class StreamBuffer {
+   public:
+    static const int REGIONS = 3;
+
+    explicit StreamBuffer(GLenum target = GL_ARRAY_BUFFER, GLsizeiptr stride = 1);
+    ~StreamBuffer();
+
+    StreamBuffer(StreamBuffer&& other) noexcept;
+    StreamBuffer& operator=(StreamBuffer&& other) noexcept;
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // Write-only pointer to at least bytes bytes, valid until unmap()
+    void* map(GLsizeiptr bytes);
+    // Returns false if the contents were lost and must not be drawn
+    bool unmap();
+    bool write(const void* data, GLsizeiptr bytes);
+
+    GLuint buffer() const { return id; }
+    GLintptr offset() const { return regionOffset; }
+    GLint first() const { return static_cast<GLint>(regionOffset / stride); }
+    // Changes whenever map() created a new buffer
+    unsigned int generation() const { return bufferGeneration; }
+
+   private:
+    GLenum target;
+    GLsizeiptr stride;
+    GLuint id = 0;
+    unsigned int bufferGeneration = 0;
+
+    GLsizeiptr regionSize = 0;
+    int region = 0;
+    GLintptr regionOffset = 0;
+    char* persistent = nullptr;
+    GLsync fences[REGIONS] = {};
+
+    void release();
+    void allocate(GLsizeiptr bytes);
+    void wait(int index);
+};
+
+#endif  // STREAM_BUFFER_H
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "Celestial_Body.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Co-rotating frame of a primary/secondary pair. Provides the effective
+// (gravitational + centrifugal) potential and the five Lagrange points. The
+// L-points are solved once in dimensionless units and reused until the pair's
+// orbital elements drift, so following the pair each frame is just a remap.
+class RotatingFrame {
+   public:
+    int primary = 0;
+    int secondary = 1;
+    // Relative change in mass ratio, semi-major axis or eccentricity that forces a
+    // new Lagrange solve
+    float elementTolerance = 1.0e-3f;
+    // Frame motion (radians, or fraction of the separation) below which consumers
+    // keep their cached effective potential
+    float motionTolerance = 1.0e-3f;
+
+    RotatingFrame();
+
+    // Rebuilds the frame from the current pair; false if the pair is unusable
+    bool update(const std::vector<Body*>& bodies);
+    bool valid() const { return isValid; }
+
+    // Effective potential as a positive well depth, matching Gravity::potential
+    float effectiveDepth(const glm::vec3& position) const;
+
+    glm::vec3 lagrangePoint(int i) const { return lagrangePoints[i]; }
+    float lagrangeDepth(int i) const { return effectiveDepth(lagrangePoints[i]); }
+
+    // Bumped when the frame moved beyond motionTolerance
+    unsigned long revision() const { return frameRevision; }
+    unsigned int solveCount() const { return solves; }
+
+    void renderLagrangePoints(const Shader& shader);
+
+   private:
+    struct Elements {
+        float massRatio = -1.0f;
+        float semiMajorAxis = 0.0f;
+        float eccentricity = 0.0f;
+    };
+
+    bool isValid = false;
+    Elements solved;
+    // Dimensionless L-point coordinates: barycentre at the origin, secondary on +x,
+    // separation of one
+    float unitX[5], unitY[5];
+
+    glm::vec3 barycenter, axisX, axisY, normal;
+    float separation = 0.0f;
+    float meanMotion2 = 0.0f;
+    float gm1 = 0.0f, gm2 = 0.0f;
+    glm::vec3 position1, position2;
+    glm::vec3 lagrangePoints[5];
+
+    // Frame state at the last revision bump
+    glm::vec3 revisedBarycenter, revisedAxisX;
+    float revisedSeparation = 0.0f;
+    unsigned long frameRevision = 0;
+    unsigned int solves = 0;
+
+    GLuint VAO;
+    StreamBuffer stream{GL_ARRAY_BUFFER, sizeof(glm::vec3)};
+    unsigned int streamGeneration = 0;
+
+    void solveLagrangePoints(float massRatio);
+    void initVertexData();
+};
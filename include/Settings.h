@@ -9,6 +9,19 @@ class Settings {
 
     bool showOrbit = true;
     bool showGravityWell = true;
+    bool showContours = true;
+    bool showStreamlines = false;
+    bool showRotatingFrame = false;
+    bool showBelt = false;
+    bool showStarfield = true;
+    bool showLabels = true;
+    bool labelAsteroids = false;
+    bool showAtmosphere = true;
+    bool planetSurfaces = true;
+    bool frustumCulling = true;
+    // Read once, when the programs are built
+    bool logarithmicDepth = true;
+    bool eclipseShadows = true;
 
    private:
     Settings() {}  // private constructor
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+
+#include "Celestial_Body.h"
+#include "utils/TripleBuffer.h"
+
+// State of one body at the end of a simulation step
+struct BodyState {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float mass;
+};
+
+// Everything the renderer needs from one simulation step. Bodies are in the
+// order the simulation was created with: the planets, then the sun.
+struct SimulationSnapshot {
+    std::vector<BodyState> bodies;
+    // Predicted path of each body as xyz triples, empty when not predicted
+    std::vector<std::vector<GLfloat>> orbits;
+    double time = 0.0;  // simulated seconds
+    // Unscaled seconds: 1 / STEP_RATE per step, signed like the time multiplier
+    // and frozen while it is zero. Drives body spin, so it keeps its on-screen
+    // speed however fast time runs.
+    double clock = 0.0;
+    unsigned long step = 0;
+};
+
+// Integrates the bodies at a fixed rate on a thread of its own, independent of
+// the frame rate, and publishes a snapshot after every step. The render thread
+// applies the newest snapshot to its own bodies once per frame.
+//
+// The simulation integrates a plain copy of the state of the bodies it was
+// created from and never touches GL or the bodies themselves. Runs that must
+// not depend on wall-clock time, such as captured video, skip start() and call
+// advance() from the render loop.
+class Simulation {
+   public:
+    // Steps per second of wall-clock time
+    static constexpr float STEP_RATE = 60.0f;
+
+    // Read at the start of every step
+    std::atomic<float> timeMultiplier{10000.0f};
+    std::atomic<bool> paused{false};
+    std::atomic<bool> predictOrbits{true};
+
+    Simulation(const std::vector<Planet>& planets, const Star& sun);
+    ~Simulation();
+
+    void start();
+    void stop();
+    // Lockstep alternative to start(): runs count steps on the calling thread
+    // and publishes the last. Not to be mixed with a started simulation.
+    void advance(unsigned int count);
+
+    // Render thread: makes the newest snapshot current, false if there is none
+    bool acquire() { return snapshots.acquire(); }
+    const SimulationSnapshot& snapshot() const { return snapshots.front(); }
+    // Copies the current snapshot into bodies, ordered as at construction
+    void apply(const std::vector<Body*>& bodies) const;
+
+    // Steps completed over the last second of wall-clock time
+    float stepRate() const { return measuredRate.load(std::memory_order_relaxed); }
+    // Wall-clock cost of the last step, in milliseconds
+    float stepTime() const { return measuredStepTime.load(std::memory_order_relaxed); }
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+   private:
+    // Integrated state, ordered as in the snapshot
+    std::vector<BodyState> state;
+    // Orbits are predicted for the planets only, the first predictedCount bodies
+    size_t predictedCount = 0;
+    std::vector<std::vector<GLfloat>> orbits;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    TripleBuffer<SimulationSnapshot> snapshots;
+    double time = 0.0;
+    double clock = 0.0;
+    unsigned long steps = 0;
+
+    std::atomic<float> measuredRate{0.0f};
+    std::atomic<float> measuredStepTime{0.0f};
+
+    void run();
+    float stepDelta() const;
+    void step(float delta_time, bool predict);
+    void publish(bool predicted);
+
+    glm::vec3 acceleration(const glm::vec3& position, size_t exclude) const;
+    void predict(size_t index, float timestep, unsigned int count,
+                 std::vector<GLfloat>& path) const;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+
+#include "Camera.h"
+#include "Celestial_Body.h"
+#include "Physics/Gravity.h"
+#include "Renderer/Shader.h"
+#include "Renderer/StreamBuffer.h"
+
+// Field lines of the summed gravitational acceleration, traced with an adaptive
+// Heun-Euler integrator. Lines are advanced in batches on the thread pool and
+// only retraced when the bodies or the seeding actually changed.
+class Streamlines {
+   public:
+    enum SeedMode { SEED_GRID = 0, SEED_BODY = 1 };
+
+    int seedMode = SEED_GRID;
+    int seedsPerSide = 24;   // grid seeding: seedsPerSide^2 seeds around the camera
+    int seedsAroundBody = 64;
+    int seedBody = 0;        // index into the body list for SEED_BODY
+    float seedRadius = 400.0f;
+    int maxSteps = 200;
+    float stepTolerance = 0.5f;  // local error budget per step, world units
+    // Retrace once any body moved more than this fraction of the seed spacing
+    float recomputeTolerance = 0.05f;
+
+    glm::vec3 color = glm::vec3(1.0f, 0.6f, 0.2f);
+
+    Streamlines();
+
+    void update(const Camera& camera, const std::vector<Body*>& bodies,
+                GLfloat extent, GLfloat height);
+    void render(const Shader& shader, GLfloat mapSize);
+
+    size_t lineCount() const { return counts.size(); }
+    unsigned int retraceCount() const { return retraces; }
+
+   private:
+    // Inputs of the last trace; the field is retraced when these drift
+    struct TraceKey {
+        int seedMode = -1, seedsPerSide = 0, seedsAroundBody = 0, seedBody = 0;
+        int maxSteps = 0;
+        float seedRadius = 0.0f, stepTolerance = 0.0f;
+        glm::vec3 origin = glm::vec3(0.0f);
+        std::vector<glm::vec3> positions;
+        std::vector<float> masses;
+    };
+
+    TraceKey traced;
+    Gravity::Sources sources;
+    std::vector<glm::vec3> seeds;
+    std::vector<GLint> firsts;
+    std::vector<GLsizei> counts;
+    unsigned int retraces = 0;
+
+    GLuint VAO;
+    StreamBuffer stream{GL_ARRAY_BUFFER, 3 * sizeof(GLfloat)};
+    unsigned int streamGeneration = 0;
+
+    void initVertexData();
+    // Points the VAO at the stream's buffer after it was (re)created
+    void bindStream();
+    bool needsRetrace(const TraceKey& key, float spacing) const;
+    void traceBatch(const TraceKey& key, size_t firstLine, size_t batchSize,
+                    float direction, float extent, float stopRadius, GLfloat* out);
+};
@@ -0,0 +1,32 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// Pieces shared by the on-disk caches: the hash their keys are built with and
+// the way an entry reaches the disk.
+namespace FileCache {
+
+// FNV-1a offset basis, the hash of no bytes
+const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+
+// FNV-1a, continued from a previous hash
+uint64_t hash(const void* data, size_t size, uint64_t seed = HASH_SEED);
+
+// Bytes written as they lie in memory
+struct Chunk {
+    const void* data;
+    size_t size;
+};
+
+// Writes the chunks in order beside path and renames the result over it, so a
+// crash never leaves half an entry and readers see the old one or the new one.
+// Creates the directory of path first. False if the entry was not replaced.
+bool write(const std::string& path, std::initializer_list<Chunk> chunks);
+
+}  // namespace FileCache
+
+#endif  // FILE_CACHE_H
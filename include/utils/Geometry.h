@@ -3,7 +3,10 @@
 
 #include <cmath>
 #include <glad/glad.h>
-#include <glm/ext/scalar_constants.hpp>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <map>
+#include <utility>
 #include <vector>
 
 namespace Geometry {
@@ -11,86 +14,72 @@ namespace Geometry {
 struct GeometryData {
     std::vector<GLfloat> vertices;
     std::vector<GLfloat> normals;
-    std::vector<GLfloat> indices;
+    std::vector<GLuint> indices;
 };
 
-inline GeometryData genUVSphere(float radius, unsigned int sectorCount,
-                                unsigned int stackCount);
+// Icosahedron subdivided `subdivisions` times, every vertex pushed back onto the
+// sphere. Triangles are nearly uniform in size, so the worst-case deviation from
+// the true sphere is the same everywhere (see icosphereError).
+inline GeometryData genIcosphere(float radius, unsigned int subdivisions) {
+    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+
+    std::vector<glm::vec3> points = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    for (auto& p : points) p = glm::normalize(p);
+
+    std::vector<GLuint> indices = {
+        0, 11, 5,  0, 5,  1, 0,  1,  7, 0,  7, 10, 0, 10, 11, 1, 5, 9, 5, 11,
+        4, 11, 10, 2, 10, 7, 6,  7,  1, 8,  3, 9,  4, 3,  4,  2, 3, 2, 6, 3,
+        6, 8,  3,  8, 9,  4, 9,  5,  2, 4,  11, 6, 2, 10, 8,  6, 7, 9, 8, 1,
+    };
+
+    for (unsigned int level = 0; level < subdivisions; level++) {
+        // Edges are shared by two triangles, so each midpoint is created once
+        std::map<uint64_t, GLuint> midpoints;
+        auto midpoint = [&](GLuint a, GLuint b) {
+            uint64_t key = a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+            auto found = midpoints.find(key);
+            if (found != midpoints.end()) return found->second;
+
+            points.push_back(glm::normalize(points[a] + points[b]));
+            GLuint index = static_cast<GLuint>(points.size() - 1);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        std::vector<GLuint> refined;
+        refined.reserve(indices.size() * 4);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            GLuint a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            GLuint ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            refined.insert(refined.end(),
+                           {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+        indices = std::move(refined);
+    }
 
-inline GeometryData genUVSphere(float radius, unsigned int sectorCount,
-                                unsigned int stackCount) {
     std::vector<GLfloat> vertices;
     std::vector<GLfloat> normals;
-    std::vector<GLfloat> indices;
-
-    const float PI = glm::pi<float>();
-
-    float x, y, z, xy;                            // vertex position
-    float nx, ny, nz, lengthInv = 1.0f / radius;  // vertex normal
-
-    float sectorStep = 2 * PI / sectorCount;
-    float stackStep = PI / stackCount;
-    float sectorAngle, stackAngle;
-
-    for (int i = 0; i <= stackCount; ++i) {
-        stackAngle = PI / 2 - i * stackStep;  // starting from pi/2 to -pi/2
-        xy = radius * cosf(stackAngle);       // r * cos(u)
-        z = radius * sinf(stackAngle);        // r * sin(u)
-
-        for (int j = 0; j <= sectorCount; ++j) {
-            sectorAngle = j * sectorStep;  // starting from 0 to 2pi
-
-            // vertex position (x, y, z)
-            x = xy * cosf(sectorAngle);
-            y = xy * sinf(sectorAngle);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-            normals.push_back(nx);
-            normals.push_back(ny);
-            normals.push_back(nz);
-        }
+    vertices.reserve(points.size() * 3);
+    normals.reserve(points.size() * 3);
+    for (const auto& p : points) {
+        vertices.insert(vertices.end(), {p.x * radius, p.y * radius, p.z * radius});
+        normals.insert(normals.end(), {p.x, p.y, p.z});
     }
 
-    // std::vector<int> lineIndices;
-    int k1, k2;
-
-    for (int i = 0; i < stackCount; ++i) {
-        k1 = i * (sectorCount + 1);  // beginning of current stack
-        k2 = k1 + sectorCount + 1;   // beginning of next stack
-
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-            // 2 triangles per sector excluding first and last stacks
-            // k1 => k2 => k1+1
-            if (i != 0) {
-                indices.push_back(k1);
-                indices.push_back(k2);
-                indices.push_back(k1 + 1);
-            }
-
-            // k1+1 => k2 => k2+1
-            if (i != (stackCount - 1)) {
-                indices.push_back(k1 + 1);
-                indices.push_back(k2);
-                indices.push_back(k2 + 1);
-            }
+    return GeometryData{std::move(vertices), std::move(normals), std::move(indices)};
+}
 
-            // // store indices for lines
-            // // vertical lines for all stacks, k1 => k2
-            // line_indices.push_back(k1);
-            // line_indices.push_back(k2);
-            // if (i != 0)  // horizontal lines except 1st stack, k1 => k+1
-            // {
-            //     line_indices.push_back(k1);
-            //     line_indices.push_back(k1 + 1);
-            // }
-        }
-    }
+// Largest distance between a unit icosphere and the true unit sphere, found at
+// the face centres: one minus the cosine of the angular circumradius of a face
+inline float icosphereError(unsigned int subdivisions) {
+    // Angle subtended by an icosahedron edge, halved by every subdivision
+    const float edgeAngle = 1.10715f / float(1u << subdivisions);
+    return 1.0f - cosf(edgeAngle / sqrtf(3.0f));
 }
 }  // namespace Geometry
 
-#endif  // GEOMETRY_H
\ No newline at end of file
+#endif  // GEOMETRY_H
@@ -0,0 +1,24 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <cstdint>
+
+// Seeded 3D gradient (Perlin) noise. The same seed always gives the same field;
+// values lie roughly in [-1, 1]. Evaluation only reads the tables, so one
+// instance can be shared by any number of threads.
+class PerlinNoise {
+   public:
+    explicit PerlinNoise(uint32_t seed);
+
+    float noise(float x, float y, float z) const;
+    // Fractal sum of octaves, each at lacunarity times the frequency and gain
+    // times the amplitude of the last, normalised back to about [-1, 1]
+    float fbm(float x, float y, float z, int octaves, float lacunarity = 2.0f,
+              float gain = 0.5f) const;
+
+   private:
+    // Doubled so lookups of i + 1 never wrap
+    uint8_t permutation[512];
+};
+
+#endif  // NOISE_H
@@ -0,0 +1,56 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads shared by every data-parallel pass (well contours,
+// streamlines, ...). Workers sleep between dispatches so there is no per-pass
+// thread creation cost.
+class ThreadPool {
+   public:
+    static ThreadPool& get() {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    // Number of threads taking part in a dispatch, including the caller
+    unsigned int threadCount() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    // Runs job(i) for every i in [0, count) and returns once all calls finished.
+    // Dispatches are serialised; jobs must not call parallelFor themselves.
+    void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+   private:
+    ThreadPool();
+    ~ThreadPool();
+
+    std::vector<std::thread> workers;
+
+    std::mutex dispatchMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextJob{0};
+    unsigned long generation = 0;
+    unsigned int busyWorkers = 0;
+    bool stopping = false;
+
+    void workerLoop();
+    void runJobs();
+};
+
+#endif  // THREAD_POOL_H
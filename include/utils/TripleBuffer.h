@@ -0,0 +1,48 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Lock-free handoff of whole values from one producer thread to one consumer
+// thread. The producer fills back() and publishes it; the consumer acquires the
+// newest published value and reads front() until it acquires again. Neither
+// side ever waits, and a published value is not written again until the
+// consumer has moved on from it.
+//
+// Slots are reused, so values holding containers stop allocating once their
+// capacity has settled.
+template <typename T>
+class TripleBuffer {
+   public:
+    // Producer: the slot to fill, never visible to the consumer until published
+    T& back() { return slots[backIndex]; }
+
+    // Producer: hands back() over and takes the slot the consumer last released
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) &
+                    INDEX_MASK;
+    }
+
+    // Consumer: moves front() to the newest published value, if there is one
+    bool acquire() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) &
+                     INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const { return slots[frontIndex]; }
+
+   private:
+    static const unsigned int INDEX_MASK = 3;
+    static const unsigned int FRESH = 4;
+
+    T slots[3];
+    unsigned int backIndex = 0;
+    unsigned int frontIndex = 1;
+    // Index of the slot in between, plus FRESH while it holds an unread value
+    std::atomic<unsigned int> middle{2};
+};
+
+#endif  // TRIPLE_BUFFER_H
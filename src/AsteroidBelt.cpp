@@ -0,0 +1,61 @@
+#include "AsteroidBelt.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <random>
+
+#include "Physics/Gravity.h"
+#include "utils/ThreadPool.h"
+
+// Asteroids placed per job
+static const size_t CHUNK = 16384;
+
+void AsteroidBelt::resize(size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    orbits.resize(count);
+    sizes.resize(count);
+    positions.resize(count);
+
+    float inner2 = innerRadius * innerRadius, outer2 = outerRadius * outerRadius;
+    for (size_t i = 0; i < count; i++) {
+        Orbit& orbit = orbits[i];
+        // Uniform density over the annulus
+        orbit.radius = sqrtf(inner2 + unit(rng) * (outer2 - inner2));
+        orbit.phase = unit(rng) * glm::two_pi<float>();
+        orbit.inclination = (unit(rng) * 2.0f - 1.0f) * maxInclination;
+        orbit.node = unit(rng) * glm::two_pi<float>();
+        // Many small bodies, few large ones
+        float s = unit(rng);
+        sizes[i] = minSize + (maxSize - minSize) * s * s * s;
+    }
+}
+
+void AsteroidBelt::update(const Body& center) {
+    const double mu = (double)Gravity::G * center.mass;
+    const glm::vec3 origin = center.position;
+
+    ThreadPool::get().parallelFor((orbits.size() + CHUNK - 1) / CHUNK, [&](size_t c) {
+        size_t end = std::min(orbits.size(), (c + 1) * CHUNK);
+        for (size_t i = c * CHUNK; i < end; i++) {
+            const Orbit& orbit = orbits[i];
+            double r = orbit.radius;
+            double meanMotion = std::sqrt(mu / (r * r * r));
+            // Wrap in double so long runs keep float precision in the angle
+            float angle = orbit.phase + (float)std::fmod(meanMotion * time,
+                                                         2.0 * glm::pi<double>());
+
+            // Orbits lie in the xz plane, tilted by a small inclination
+            float x = cosf(angle), z = sinf(angle);
+            float y = orbit.inclination * sinf(angle - orbit.node);
+            positions[i] = origin + orbit.radius * glm::vec3(x, y, z);
+        }
+    });
+}
+
+void AsteroidBelt::submit(BodyRenderer& renderer) const {
+    renderer.submitSpheres(positions.data(), sizes.data(), positions.size(),
+                           glm::vec4(color, 0.0f), glm::vec4(material, 0.0f));
+}
@@ -1,45 +1,41 @@
 #include "Celestial_Body.h"
 #include "GravityWell.h"
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
 #include "Renderer/Shader.h"
+#include <cmath>
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 using glm::vec3;
 
-std::vector<GLfloat> Body::predictPositions(const Body& me,
-                                            const std::vector<Body*>& others,
-                                            float timestep, unsigned int steps) {
-    glm::vec3 pos = me.position;
-    glm::vec3 vel = me.velocity;
-    const float G = 6.67e-11f;
-
-    std::vector<GLfloat> path;
-    path.reserve(steps * 3 + 1);
-
-    path.push_back(pos.x);
-    path.push_back(pos.y);
-    path.push_back(pos.z);
-
-    for (unsigned int i = 0; i < steps; ++i) {
-        glm::vec3 netAcc(0.0f);
-        for (auto* other : others) {
-            if (other == &me) continue;
-            glm::vec3 d = other->position - pos;
-            float r2 = glm::dot(d, d);
-            if (r2 <= 0.0f) continue;
-            netAcc += (G * other->mass / r2) * glm::normalize(d);
-        }
-        vel += netAcc * timestep;
-        pos += vel * timestep;
-        path.push_back(pos.x);
-        path.push_back(pos.y);
-        path.push_back(pos.z);
-    }
-    return path;
+Body::~Body() {
+    if (this->orbitVAO == 0) return;
+    // Deleting the bound array unbinds it behind GLState's back
+    GLState::get().bindVertexArray(0);
+    glDeleteVertexArrays(1, &this->orbitVAO);
 }
 
+Body::Body(Body&& other) noexcept
+    : position(other.position),
+      velocity(other.velocity),
+      mass(other.mass),
+      name(std::move(other.name)),
+      shadowList(other.shadowList),
+      surfaceLayer(other.surfaceLayer),
+      radius(other.radius),
+      orbitVAO(std::exchange(other.orbitVAO, 0)),
+      orbitEBO(std::exchange(other.orbitEBO, 0)),
+      orbitStream(std::move(other.orbitStream)),
+      orbitGeneration(other.orbitGeneration),
+      orbitVertexCount(std::exchange(other.orbitVertexCount, 0)),
+      orbitVertices(std::move(other.orbitVertices)),
+      orbitIndices(std::move(other.orbitIndices)),
+      orbitSphere(other.orbitSphere) {}
+
 void Body::drawOrbit(Shader& shader) {
-    glBindVertexArray(this->orbitVAO);
+    GLState::get().bindVertexArray(this->orbitVAO);
 
     glm::mat4 model(1.0f);
     shader.setMat4("model", model);
@@ -47,9 +43,26 @@ void Body::drawOrbit(Shader& shader) {
     glm::vec4 color(1.0f, 0.0f, 0.0f, 0.5f);
     shader.setVec4("color", color);
 
-    glLineWidth(1.0);
+    GLState::get().lineWidth(1.0f);
     // glDrawElements(GL_LINES, indices.size(), GL_UNSIGNED_INT, 0);
-    glDrawArrays(GL_LINE_STRIP, 0, this->orbitVertices.size() / 3);
+    glDrawArrays(GL_LINE_STRIP, this->orbitStream.first(), this->orbitVertexCount);
+}
+
+void Body::setOrbit(const std::vector<GLfloat>& path) {
+    // Assignment keeps the capacity of the last orbit, so steady state copies
+    // without allocating
+    this->orbitVertices = path;
+
+    glm::vec3 lo(INFINITY), hi(-INFINITY);
+    for (size_t i = 0; i + 2 < orbitVertices.size(); i += 3) {
+        glm::vec3 p(orbitVertices[i], orbitVertices[i + 1], orbitVertices[i + 2]);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    if (orbitVertices.empty()) lo = hi = this->position;
+
+    glm::vec3 center = (lo + hi) * 0.5f;
+    this->orbitSphere = glm::vec4(center, glm::length(hi - center));
 }
 
 void Body::updateOrbitVertexData() {
@@ -58,9 +71,30 @@ void Body::updateOrbitVertexData() {
     //     this->orbitIndices.push_back(i + 1);
     // }
 
-    glBindBuffer(GL_ARRAY_BUFFER, this->orbitVBO);
-    glBufferData(GL_ARRAY_BUFFER, this->orbitVertices.size() * sizeof(GLfloat),
-                 this->orbitVertices.data(), GL_STATIC_DRAW);
+    this->orbitVertexCount = 0;
+    if (this->orbitVertices.empty()) return;
+
+    // The orbit is re-predicted every frame, so it streams through a ring
+    // rather than re-specifying the buffer
+    if (!this->orbitStream.write(this->orbitVertices.data(),
+                                 this->orbitVertices.size() * sizeof(GLfloat)))
+        return;
+
+    if (this->orbitStream.generation() != this->orbitGeneration) {
+        if (GLExt::directStateAccess()) {
+            GLExt::VertexArrayVertexBuffer(this->orbitVAO, 0,
+                                           this->orbitStream.buffer(), 0,
+                                           3 * sizeof(GLfloat));
+        } else {
+            GLState::get().bindVertexArray(this->orbitVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, this->orbitStream.buffer());
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                                  (void*)0);
+            glEnableVertexAttribArray(0);
+        }
+        this->orbitGeneration = this->orbitStream.generation();
+    }
+    this->orbitVertexCount = static_cast<GLsizei>(this->orbitVertices.size() / 3);
 
     // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->orbitEBO);
     // glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->orbitIndices.size() *
@@ -69,26 +103,23 @@ void Body::updateOrbitVertexData() {
 }
 
 void Body::initOrbitVertexData() {
+    // The vertex attribute is pointed at the orbit stream on its first upload
+    if (GLExt::directStateAccess()) {
+        GLExt::CreateVertexArrays(1, &this->orbitVAO);
+        GLExt::vertexAttribute(this->orbitVAO, 0, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        return;
+    }
+
     glGenVertexArrays(1, &this->orbitVAO);
-    glBindVertexArray(this->orbitVAO);
-    glGenBuffers(1, &this->orbitVBO);
+    GLState::get().bindVertexArray(this->orbitVAO);
     // glGenBuffers(1, &this->orbitEBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, this->orbitVBO);
-    glBufferData(GL_ARRAY_BUFFER, this->orbitVertices.size() * sizeof(GLfloat),
-                 this->orbitVertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
-
     // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->orbitEBO);
     // glBufferData(GL_ELEMENT_ARRAY_BUFFER,
     //              this->orbitIndices.size() * sizeof(GLuint),
     //              this->orbitIndices.data(), GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
+    GLState::get().bindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-    glEnable(GL_DEPTH_TEST);
 }
\ No newline at end of file
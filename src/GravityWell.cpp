@@ -1,14 +1,16 @@
 #include "GravityWell.h"
+#include "Physics/Gravity.h"
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
 #include "Renderer/Shader.h"
+#include <algorithm>
 #include <cmath>
 #include <glm/fwd.hpp>
 
 GravityWell::GravityWell(GLfloat gridSize) : gridSize(gridSize) { initVertexData(); }
 
-void GravityWell::render(const Shader& shader, const Camera& camera) {
-    glEnable(GL_DEPTH_TEST);
-
-    glBindVertexArray(this->VAO);
+void GravityWell::render(const Shader& shader) {
+    GLState::get().bindVertexArray(this->VAO);
 
     // glm::vec3 cam = camera.Position;
     // glm::vec3 gridSnap(cam.x - fmodf(cam.x, gridSize), 0.0,
@@ -24,85 +26,387 @@ void GravityWell::render(const Shader& shader, const Camera& camera) {
 
     shader.setVec3("gridColor", gridColor);
     shader.setFloat("mapSize", this->mapSize);
-    shader.setVec3("cameraPos", camera.Position);
-
-    glLineWidth(1.0);
-
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    glDrawElements(GL_LINES, indices.size(), GL_UNSIGNED_INT, 0);
+    GLState::get().lineWidth(1.0f);
+
+    glDrawElements(GL_LINES, edgeIndexOffset, GL_UNSIGNED_INT, 0);
+
+    // Close the window: its last row and column of tiles also draw the far edges
+    // no neighbour inside the window draws for them
+    if (tiles.empty()) return;
+    edgeCounts.clear();
+    edgeOffsets.clear();
+    int n = static_cast<int>(tilesPerSide);
+    const GLsizei edgeIndices = 2 * TILE_SIZE;
+    int farX = ((windowTileX + n - 1) % n + n) % n;
+    int farZ = ((windowTileZ + n - 1) % n + n) % n;
+    for (int t = 0; t < n; t++) {
+        int alongX = ((windowTileX + t) % n + n) % n;
+        int alongZ = ((windowTileZ + t) % n + n) % n;
+        unsigned int xSlot = farX * tilesPerSide + alongZ;
+        unsigned int zSlot = alongX * tilesPerSide + farZ;
+
+        size_t xFirst = edgeIndexOffset + xSlot * 2 * edgeIndices;
+        size_t zFirst = edgeIndexOffset + zSlot * 2 * edgeIndices + edgeIndices;
+        edgeCounts.push_back(edgeIndices);
+        edgeOffsets.push_back((const void*)(xFirst * sizeof(GLuint)));
+        edgeCounts.push_back(edgeIndices);
+        edgeOffsets.push_back((const void*)(zFirst * sizeof(GLuint)));
+    }
+    glMultiDrawElements(GL_LINES, edgeCounts.data(), GL_UNSIGNED_INT,
+                        edgeOffsets.data(), static_cast<GLsizei>(edgeCounts.size()));
 }
 
 void GravityWell::updateVertexData(const Camera& camera,
-                                   const std::vector<Body*>& other_bodies) {
-    this->vertices.clear();
-    this->indices.clear();
+                                   const std::vector<Body*>& other_bodies,
+                                   const RotatingFrame* frame) {
+    const GLfloat tileWorldSize = gridSize * TILE_SIZE;
+    unsigned int sideTiles = static_cast<unsigned int>(ceilf(mapSize / tileWorldSize));
+    if (sideTiles == 0) sideTiles = 1;
+
+    if (sideTiles != this->tilesPerSide || gridSize != this->layoutGridSize)
+        initTiles(sideTiles);
+
+    // The other renderer's buffer is stale, so refill everything on a switch
+    if (renderMode != uploadedMode) {
+        for (Tile& tile : this->tiles) tile.valid = false;
+        uploadedMode = renderMode;
+    }
+    if (renderMode == RENDER_HEIGHTMAP && meshResolution != builtMeshResolution)
+        initHeightMapMesh();
+
+    if (other_bodies.size() != this->bodyCount) {
+        this->bodyCount = other_bodies.size();
+        this->contributions.assign(
+            this->tiles.size() * contributionLayers() * tileVertexCount(), 0.0f);
+        for (Tile& tile : this->tiles) {
+            tile.valid = false;
+            tile.bodyPositions.assign(this->bodyCount, glm::vec3(0.0f));
+        }
+    }
 
+    // Snap the window to whole tiles so a camera move only shifts tile ownership
     glm::vec3 cam = camera.Position;
-    glm::vec3 gridSnap(cam.x - fmodf(cam.x, gridSize), 0.0f,
-                       cam.z - fmodf(cam.z, gridSize));
+    int originX = static_cast<int>(floorf((cam.x - mapSize / 2.0f) / tileWorldSize));
+    int originZ = static_cast<int>(floorf((cam.z - mapSize / 2.0f) / tileWorldSize));
+    windowOrigin = glm::vec2(originX * tileWorldSize, originZ * tileWorldSize);
+    windowTileX = originX;
+    windowTileZ = originZ;
 
-    glm::mat4 model(1.0f);
-    model = glm::translate(model, glm::vec3(-mapSize / 2.0f, 0.0f, -mapSize / 2.0f));
-    model = glm::translate(model, gridSnap);
+    this->dirtyTiles = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBindTexture(GL_TEXTURE_2D, this->heightMap);
+
+    for (unsigned int tx = 0; tx < tilesPerSide; tx++) {
+        for (unsigned int tz = 0; tz < tilesPerSide; tz++) {
+            int worldX = originX + static_cast<int>(tx);
+            int worldZ = originZ + static_cast<int>(tz);
+
+            int n = static_cast<int>(tilesPerSide);
+            unsigned int slot = ((worldX % n + n) % n) * tilesPerSide +
+                                ((worldZ % n + n) % n);
+
+            bool updated = frame != nullptr && frame->valid()
+                               ? updateEffectiveTile(slot, worldX, worldZ, *frame)
+                               : updateTile(slot, worldX, worldZ, other_bodies);
+            if (!updated) continue;
+
+            if (renderMode == RENDER_HEIGHTMAP) {
+                uploadTexels(slot);
+            } else {
+                // Tiles persist across frames and only a few change, so they
+                // are patched in place rather than streamed through a ring
+                GLintptr offset = slot * tileVertexCount() * 3 * sizeof(GLfloat);
+                GLsizeiptr bytes = tileVertexCount() * 3 * sizeof(GLfloat);
+                const GLfloat* data = &this->vertices[slot * tileVertexCount() * 3];
+                if (GLExt::directStateAccess())
+                    GLExt::NamedBufferSubData(this->VBO, offset, bytes, data);
+                else
+                    glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+            }
+            this->dirtyTiles++;
+        }
+    }
 
-    GLfloat x, y = 50.0f, z;
-    unsigned int slices = static_cast<unsigned int>(mapSize / gridSize);
+    if (this->dirtyTiles > 0) this->wellRevision++;
+}
 
-    for (unsigned int i = 0; i < slices; i++) {
-        x = i * gridSize;
+bool GravityWell::updateTile(unsigned int slot, int worldX, int worldZ,
+                             const std::vector<Body*>& other_bodies) {
+    Tile& tile = this->tiles[slot];
+    const GLfloat tileWorldSize = gridSize * TILE_SIZE;
+    const unsigned int rowLength = TILE_SIZE + 1;
+
+    // Tiles last filled by the effective potential have no per-body cache
+    bool reassigned = !tile.valid || tile.worldX != worldX || tile.worldZ != worldZ ||
+                      tile.frameRevision != 0;
+    bool changed = reassigned;
+
+    glm::vec3 tileMin(worldX * tileWorldSize, planeHeight, worldZ * tileWorldSize);
+    glm::vec3 tileMax = tileMin + glm::vec3(tileWorldSize, 0.0f, tileWorldSize);
+
+    const size_t layers = contributionLayers();
+    const size_t cachedBodies = std::min<size_t>(bodyCount, MAX_CACHED_BODIES);
+    bool restMoved = reassigned;
+    for (size_t b = 0; b < other_bodies.size(); b++) {
+        const glm::vec3& bodyPosition = other_bodies[b]->position;
+
+        if (!reassigned) {
+            // Contribution error grows with displacement over distance, so distant
+            // tiles tolerate proportionally larger moves
+            glm::vec3 nearest = glm::clamp(bodyPosition, tileMin, tileMax);
+            float reach = glm::max(glm::length(bodyPosition - nearest), gridSize);
+            float moved = glm::length(bodyPosition - tile.bodyPositions[b]);
+            if (moved <= dirtyTolerance * reach) continue;
+        }
+        if (b >= cachedBodies) {
+            restMoved = true;
+            continue;
+        }
 
-        for (unsigned int j = 0; j < slices; j++) {
-            z = j * gridSize;
-            glm::vec3 worldVertex = model * glm::vec4(x, y, z, 1.0f);
+        addContribution(&this->contributions[(slot * layers + b) * tileVertexCount()],
+                        tileMin, *other_bodies[b], false);
+        tile.bodyPositions[b] = bodyPosition;
+        changed = true;
+    }
 
-            const float G = 6.67e-11f;
+    // The shared layer is rebuilt from every body it holds
+    if (restMoved && bodyCount > cachedBodies) {
+        GLfloat* rest = &this->contributions[(slot * layers + cachedBodies) *
+                                             tileVertexCount()];
+        for (size_t b = cachedBodies; b < bodyCount; b++) {
+            addContribution(rest, tileMin, *other_bodies[b], b > cachedBodies);
+            tile.bodyPositions[b] = other_bodies[b]->position;
+        }
+        changed = true;
+    }
 
-            for (unsigned int i = 0; i < other_bodies.size(); i++) {
-                const Body* other_body = other_bodies[i];
+    if (!changed) return false;
 
-                glm::vec3 distance_vector = other_body->position - worldVertex;
-                float distance_mag = glm::length(distance_vector);
+    tile.worldX = worldX;
+    tile.worldZ = worldZ;
+    tile.valid = true;
+    tile.frameRevision = 0;
 
-                if (distance_mag == 0) continue;
+    const GLfloat* contribution =
+        &this->contributions[slot * layers * tileVertexCount()];
+    GLfloat* vertex = &this->vertices[slot * tileVertexCount() * 3];
+    for (unsigned int v = 0; v < tileVertexCount(); v++) {
+        GLfloat depth = 0.0f;
+        for (size_t layer = 0; layer < layers; layer++)
+            depth += contribution[layer * tileVertexCount() + v];
 
-                // Calculate Gravitional Acceleration from Each Planet
-                float acceleration = G * other_body->mass /
-                                    (distance_mag);
+        vertex[v * 3 + 0] = tileMin.x + (v / rowLength) * gridSize;
+        vertex[v * 3 + 1] = planeHeight - depth;
+        vertex[v * 3 + 2] = tileMin.z + (v % rowLength) * gridSize;
+    }
+    return true;
+}
 
-                worldVertex.y -= acceleration * 2.0e5f;
-            }
+size_t GravityWell::contributionLayers() const {
+    if (bodyCount <= MAX_CACHED_BODIES) return bodyCount;
+    return MAX_CACHED_BODIES + 1;
+}
 
-            this->vertices.push_back(worldVertex.x);
-            this->vertices.push_back(worldVertex.y);
-            this->vertices.push_back(worldVertex.z);
+void GravityWell::addContribution(GLfloat* contribution, const glm::vec3& tileMin,
+                                  const Body& body, bool accumulate) const {
+    const unsigned int rowLength = TILE_SIZE + 1;
+    for (unsigned int i = 0; i < rowLength; i++) {
+        for (unsigned int j = 0; j < rowLength; j++) {
+            glm::vec3 vertex = tileMin + glm::vec3(i * gridSize, 0.0f, j * gridSize);
+            GLfloat depth = Gravity::potential(vertex, body) * depthScale;
+            if (accumulate)
+                contribution[i * rowLength + j] += depth;
+            else
+                contribution[i * rowLength + j] = depth;
         }
     }
+}
 
-    unsigned int index = 0;
-    for (unsigned int row = 0; row < slices; row++) {
-        for (unsigned int col = 0; col < slices; col++) {
-            if (col + 1 < slices) {
+bool GravityWell::updateEffectiveTile(unsigned int slot, int worldX, int worldZ,
+                                      const RotatingFrame& frame) {
+    Tile& tile = this->tiles[slot];
+    bool reassigned = !tile.valid || tile.worldX != worldX || tile.worldZ != worldZ;
+
+    // The effective potential moves with the pair as a whole, so tiles are keyed
+    // on the frame revision rather than on individual bodies
+    if (!reassigned && tile.frameRevision == frame.revision()) return false;
+
+    const GLfloat tileWorldSize = gridSize * TILE_SIZE;
+    const unsigned int rowLength = TILE_SIZE + 1;
+    glm::vec3 tileMin(worldX * tileWorldSize, planeHeight, worldZ * tileWorldSize);
+
+    GLfloat* vertex = &this->vertices[slot * tileVertexCount() * 3];
+    for (unsigned int v = 0; v < tileVertexCount(); v++) {
+        glm::vec3 position = tileMin + glm::vec3((v / rowLength) * gridSize, 0.0f,
+                                                 (v % rowLength) * gridSize);
+
+        vertex[v * 3 + 0] = position.x;
+        vertex[v * 3 + 1] = planeHeight - frame.effectiveDepth(position) * depthScale;
+        vertex[v * 3 + 2] = position.z;
+    }
+
+    tile.worldX = worldX;
+    tile.worldZ = worldZ;
+    tile.valid = true;
+    tile.frameRevision = frame.revision();
+    return true;
+}
+
+void GravityWell::initTiles(unsigned int sideTiles) {
+    this->tilesPerSide = sideTiles;
+    this->layoutGridSize = gridSize;
+
+    unsigned int slotCount = sideTiles * sideTiles;
+    this->tiles.assign(slotCount, Tile());
+    for (Tile& tile : this->tiles)
+        tile.bodyPositions.assign(bodyCount, glm::vec3(0.0f));
+
+    this->contributions.assign(slotCount * contributionLayers() * tileVertexCount(),
+                               0.0f);
+    this->vertices.assign(slotCount * tileVertexCount() * 3, 0.0f);
+    this->indices.clear();
+
+    // Each tile draws its interior lines plus its near edges; the far edges belong
+    // to the neighbouring tile so shared lines are never blended twice
+    const unsigned int rowLength = TILE_SIZE + 1;
+    for (unsigned int slot = 0; slot < slotCount; slot++) {
+        GLuint base = slot * tileVertexCount();
+        for (unsigned int i = 0; i < TILE_SIZE; i++) {
+            for (unsigned int j = 0; j < TILE_SIZE; j++) {
+                GLuint index = base + i * rowLength + j;
                 indices.push_back(index);
                 indices.push_back(index + 1);
-            }
 
-            if (row + 1 < slices) {
                 indices.push_back(index);
-                indices.push_back(index + slices);
+                indices.push_back(index + rowLength);
             }
-            index++;
         }
     }
+
+    // Then each slot's far x edge and far z edge, for whichever slots end up on
+    // the window's far side
+    edgeIndexOffset = static_cast<GLsizei>(indices.size());
+    for (unsigned int slot = 0; slot < slotCount; slot++) {
+        GLuint base = slot * tileVertexCount();
+        for (unsigned int j = 0; j < TILE_SIZE; j++) {
+            GLuint index = base + TILE_SIZE * rowLength + j;
+            indices.push_back(index);
+            indices.push_back(index + 1);
+        }
+        for (unsigned int i = 0; i < TILE_SIZE; i++) {
+            GLuint index = base + i * rowLength + TILE_SIZE;
+            indices.push_back(index);
+            indices.push_back(index + rowLength);
+        }
+    }
+
+    GLState::get().bindVertexArray(this->VAO);
+
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    // glBufferSubData(GL_ARRAY_BUFFER, 0, this->vertices.size() * sizeof(GLfloat),
-    //                 this->vertices.data());
     glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(GLfloat),
-                 this->vertices.data(), GL_STATIC_DRAW);
+                 this->vertices.data(), GL_DYNAMIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint),
                  this->indices.data(), GL_STATIC_DRAW);
+
+    GLState::get().bindVertexArray(0);
+
+    GLsizei texels = sideTiles * TILE_SIZE;
+    glBindTexture(GL_TEXTURE_2D, this->heightMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, texels, texels, 0, GL_RED, GL_FLOAT,
+                 nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GravityWell::uploadTexels(unsigned int slot) {
+    const unsigned int rowLength = TILE_SIZE + 1;
+    const GLfloat* vertex = &this->vertices[slot * tileVertexCount() * 3];
+
+    // The far edge duplicates the neighbouring tile's first row, so skip it. Rows
+    // of the sub-image run along z.
+    texelStaging.resize(TILE_SIZE * TILE_SIZE);
+    for (unsigned int i = 0; i < TILE_SIZE; i++)
+        for (unsigned int j = 0; j < TILE_SIZE; j++)
+            texelStaging[j * TILE_SIZE + i] =
+                planeHeight - vertex[(i * rowLength + j) * 3 + 1];
+
+    GLint x = (slot / tilesPerSide) * TILE_SIZE;
+    GLint y = (slot % tilesPerSide) * TILE_SIZE;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, TILE_SIZE, TILE_SIZE, GL_RED, GL_FLOAT,
+                    texelStaging.data());
+}
+
+void GravityWell::renderHeightMap(const Shader& shader) {
+    if (mapIndexCount == 0 || tilesPerSide == 0) return;
+
+    GLState::get().bindVertexArray(this->mapVAO);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, this->heightMap);
+    shader.setInt("heightMap", 0);
+
+    GLfloat texels = static_cast<GLfloat>(tilesPerSide * TILE_SIZE);
+    shader.setVec2("windowOrigin", windowOrigin);
+    shader.setFloat("windowSize", texels * gridSize);
+    shader.setFloat("texelCount", texels);
+    shader.setFloat("planeHeight", planeHeight);
+
+    shader.setVec3("gridColor", glm::vec3(1.0f, 1.0f, 1.0f));
+    shader.setVec3("slopeColor", glm::vec3(1.0f, 0.35f, 0.1f));
+    shader.setFloat("slopeScale", slopeShading ? slopeScale : 0.0f);
+    shader.setFloat("mapSize", this->mapSize);
+
+    GLState::get().lineWidth(1.0f);
+
+    glDrawElements(GL_LINES, mapIndexCount, GL_UNSIGNED_INT, 0);
+}
+
+void GravityWell::initHeightMapMesh() {
+    builtMeshResolution = meshResolution < 1 ? 1 : meshResolution;
+    const unsigned int side = builtMeshResolution + 1;
+
+    // Unit-square grid; the vertex shader places it over the current window
+    std::vector<GLfloat> gridVertices;
+    std::vector<GLuint> gridIndices;
+    gridVertices.reserve(side * side * 2);
+    for (unsigned int i = 0; i < side; i++) {
+        for (unsigned int j = 0; j < side; j++) {
+            gridVertices.push_back(static_cast<GLfloat>(i) / builtMeshResolution);
+            gridVertices.push_back(static_cast<GLfloat>(j) / builtMeshResolution);
+        }
+    }
+
+    unsigned int index = 0;
+    for (unsigned int row = 0; row < side; row++) {
+        for (unsigned int col = 0; col < side; col++) {
+            if (col + 1 < side) {
+                gridIndices.push_back(index);
+                gridIndices.push_back(index + 1);
+            }
+
+            if (row + 1 < side) {
+                gridIndices.push_back(index);
+                gridIndices.push_back(index + side);
+            }
+            index++;
+        }
+    }
+    mapIndexCount = static_cast<GLsizei>(gridIndices.size());
+
+    GLState::get().bindVertexArray(this->mapVAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->mapVBO);
+    glBufferData(GL_ARRAY_BUFFER, gridVertices.size() * sizeof(GLfloat),
+                 gridVertices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->mapEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, gridIndices.size() * sizeof(GLuint),
+                 gridIndices.data(), GL_STATIC_DRAW);
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void GravityWell::initVertexData() {
@@ -110,7 +414,7 @@ void GravityWell::initVertexData() {
     indices.clear();
 
     glGenVertexArrays(1, &this->VAO);
-    glBindVertexArray(this->VAO);
+    GLState::get().bindVertexArray(this->VAO);
     glGenBuffers(1, &this->VBO);
     glGenBuffers(1, &this->EBO);
 
@@ -125,9 +429,30 @@ void GravityWell::initVertexData() {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->indices.size() * sizeof(GLuint),
                  this->indices.data(), GL_STATIC_DRAW);
 
-    glBindVertexArray(0);
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glGenVertexArrays(1, &this->mapVAO);
+    GLState::get().bindVertexArray(this->mapVAO);
+    glGenBuffers(1, &this->mapVBO);
+    glGenBuffers(1, &this->mapEBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->mapVBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    GLState::get().bindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    glEnable(GL_DEPTH_TEST);
+    // Texels are addressed toroidally and filtered by gravity_well_map.vs, which
+    // clamps to the window, so the sampler itself never wraps or blends
+    glGenTextures(1, &this->heightMap);
+    glBindTexture(GL_TEXTURE_2D, this->heightMap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "IsoContours.h"
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Corner order: 0 = (i, j), 1 = (i + 1, j), 2 = (i + 1, j + 1), 3 = (i, j + 1).
+// Edge e joins corner e and corner (e + 1) % 4. Each case lists up to two
+// segments as edge pairs; saddles (5, 10) are resolved separately.
+static const int SEGMENT_EDGES[16][4] = {
+    {-1, -1, -1, -1}, {3, 0, -1, -1}, {0, 1, -1, -1}, {3, 1, -1, -1},
+    {1, 2, -1, -1},   {3, 0, 1, 2},   {0, 2, -1, -1}, {3, 2, -1, -1},
+    {2, 3, -1, -1},   {0, 2, -1, -1}, {0, 1, 2, 3},   {1, 2, -1, -1},
+    {1, 3, -1, -1},   {0, 1, -1, -1}, {3, 0, -1, -1}, {-1, -1, -1, -1}};
+
+IsoContours::IsoContours() { initVertexData(); }
+
+void IsoContours::update(const GravityWell& well) {
+    if (well.revision() == extractedRevision && levelCount == extractedLevelCount &&
+        pinnedDepths == extractedPinned)
+        return;
+
+    extractedRevision = well.revision();
+    extractedLevelCount = levelCount;
+    extractedPinned = pinnedDepths;
+
+    const std::vector<GLfloat>& vertices = well.getVertices();
+    const size_t tileFloats = GravityWell::tileVertexCount() * 3;
+    const size_t tileCount = vertices.size() / tileFloats;
+
+    computeLevels(well);
+    tileSegments.assign(tileCount + 1, 0);
+
+    // Pass 1: count segments per tile so every tile gets a fixed output range
+    ThreadPool::get().parallelFor(tileCount, [&](size_t tile) {
+        tileSegments[tile + 1] = extractTile(&vertices[tile * tileFloats], nullptr);
+    });
+
+    for (size_t tile = 0; tile < tileCount; tile++)
+        tileSegments[tile + 1] += tileSegments[tile];
+    segments = tileSegments[tileCount];
+
+    if (segments == 0) return;
+
+    // A fresh stream region, so the driver never waits on the last frame
+    GLsizeiptr bytes = segments * 2 * 3 * sizeof(GLfloat);
+    GLfloat* mapped = static_cast<GLfloat*>(this->stream.map(bytes));
+    if (mapped == nullptr) {
+        segments = 0;
+        return;
+    }
+
+    // Pass 2: workers write their segments directly into the mapped buffer
+    ThreadPool::get().parallelFor(tileCount, [&](size_t tile) {
+        extractTile(&vertices[tile * tileFloats], mapped + tileSegments[tile] * 6);
+    });
+
+    if (!this->stream.unmap()) segments = 0;
+    bindStream();
+}
+
+void IsoContours::render(const Shader& shader, GLfloat mapSize) {
+    if (segments == 0) return;
+
+    GLState::get().bindVertexArray(this->VAO);
+
+    glm::mat4 model(1.0f);
+    shader.setMat4("model", model);
+    shader.setVec3("gridColor", this->color);
+    shader.setFloat("mapSize", mapSize);
+
+    GLState::get().lineWidth(1.0f);
+    glDrawArrays(GL_LINES, this->stream.first(), segments * 2);
+}
+
+void IsoContours::computeLevels(const GravityWell& well) {
+    const std::vector<GLfloat>& vertices = well.getVertices();
+
+    GLfloat minDepth = std::numeric_limits<GLfloat>::max();
+    GLfloat maxDepth = std::numeric_limits<GLfloat>::lowest();
+    for (size_t v = 1; v < vertices.size(); v += 3) {
+        GLfloat depth = well.planeHeight - vertices[v];
+        minDepth = std::min(minDepth, depth);
+        maxDepth = std::max(maxDepth, depth);
+    }
+
+    levels.clear();
+    for (GLfloat depth : pinnedDepths) levels.push_back(well.planeHeight - depth);
+
+    // The potential falls off as 1/r, so geometric spacing gives evenly spaced
+    // rings around each body; fall back to linear spacing for a flat well
+    bool geometric = minDepth > 0.0f;
+    for (int k = 0; k < levelCount && maxDepth > minDepth; k++) {
+        float t = (k + 0.5f) / levelCount;
+        GLfloat depth = geometric ? minDepth * powf(maxDepth / minDepth, t)
+                                  : minDepth + (maxDepth - minDepth) * t;
+        levels.push_back(well.planeHeight - depth);
+    }
+    std::sort(levels.begin(), levels.end());
+}
+
+size_t IsoContours::extractTile(const GLfloat* tile, GLfloat* out) const {
+    const unsigned int rowLength = GravityWell::TILE_SIZE + 1;
+    size_t count = 0;
+
+    for (unsigned int i = 0; i < GravityWell::TILE_SIZE; i++) {
+        for (unsigned int j = 0; j < GravityWell::TILE_SIZE; j++) {
+            const GLfloat* corner[4] = {&tile[(i * rowLength + j) * 3],
+                                        &tile[((i + 1) * rowLength + j) * 3],
+                                        &tile[((i + 1) * rowLength + j + 1) * 3],
+                                        &tile[(i * rowLength + j + 1) * 3]};
+
+            GLfloat low = std::min(std::min(corner[0][1], corner[1][1]),
+                                   std::min(corner[2][1], corner[3][1]));
+            GLfloat high = std::max(std::max(corner[0][1], corner[1][1]),
+                                    std::max(corner[2][1], corner[3][1]));
+
+            // Only levels inside [low, high) can cross this cell
+            auto first = std::lower_bound(levels.begin(), levels.end(), low);
+            auto last = std::lower_bound(first, levels.end(), high);
+
+            for (auto level = first; level != last; ++level) {
+                int cell = 0;
+                for (int c = 0; c < 4; c++)
+                    if (corner[c][1] > *level) cell |= 1 << c;
+
+                int edges[4] = {SEGMENT_EDGES[cell][0], SEGMENT_EDGES[cell][1],
+                                SEGMENT_EDGES[cell][2], SEGMENT_EDGES[cell][3]};
+
+                // Saddle: when the cell centre is above the level the two raised
+                // corners are connected, so the lowered corners are cut off instead
+                if (cell == 5 || cell == 10) {
+                    GLfloat centre = 0.25f * (corner[0][1] + corner[1][1] +
+                                              corner[2][1] + corner[3][1]);
+                    if (centre > *level) {
+                        const int* split = SEGMENT_EDGES[cell == 5 ? 10 : 5];
+                        std::copy(split, split + 4, edges);
+                    }
+                }
+
+                for (int s = 0; s < 4 && edges[s] >= 0; s += 2) {
+                    if (out != nullptr) {
+                        for (int e = s; e < s + 2; e++) {
+                            const GLfloat* a = corner[edges[e]];
+                            const GLfloat* b = corner[(edges[e] + 1) % 4];
+                            float t = (*level - a[1]) / (b[1] - a[1]);
+
+                            *out++ = a[0] + (b[0] - a[0]) * t;
+                            *out++ = *level;
+                            *out++ = a[2] + (b[2] - a[2]) * t;
+                        }
+                    }
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+void IsoContours::initVertexData() {
+    // The vertex attribute is pointed at the stream once it has a buffer
+    if (GLExt::directStateAccess()) {
+        GLExt::CreateVertexArrays(1, &this->VAO);
+        GLExt::vertexAttribute(this->VAO, 0, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        return;
+    }
+    glGenVertexArrays(1, &this->VAO);
+}
+
+void IsoContours::bindStream() {
+    if (this->stream.generation() == this->streamGeneration) return;
+    this->streamGeneration = this->stream.generation();
+
+    if (GLExt::directStateAccess()) {
+        GLExt::VertexArrayVertexBuffer(this->VAO, 0, this->stream.buffer(), 0,
+                                       3 * sizeof(GLfloat));
+        return;
+    }
+    GLState::get().bindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->stream.buffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+}
@@ -0,0 +1,303 @@
+#include "Renderer/Atmosphere.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
+#include "utils/FileCache.h"
+#include "utils/ThreadPool.h"
+
+namespace {
+
+const uint32_t MAGIC = 0x41545350;  // "PSTA"
+const uint32_t VERSION = 1;
+const int TRANSMITTANCE_STEPS = 64;
+const int SCATTERING_STEPS = 32;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    float buildTime;
+    uint32_t padding;
+};
+
+// Texel centres cover [0, 1], so linear filtering interpolates between entries
+float texelCoordinate(int i, int size) { return (i + 0.5f) / size; }
+
+// Distance from radius r along zenith cosine mu to the sphere of radius top
+float distanceToSphere(float r, float mu, float top) {
+    float discriminant = r * r * (mu * mu - 1.0f) + top * top;
+    return std::max(-r * mu + std::sqrt(std::max(discriminant, 0.0f)), 0.0f);
+}
+
+// Distance to the ground, or a negative number if the ray misses it
+float distanceToGround(float r, float mu) {
+    float discriminant = r * r * (mu * mu - 1.0f) + 1.0f;
+    if (mu >= 0.0f || discriminant < 0.0f) return -1.0f;
+    return -r * mu - std::sqrt(discriminant);
+}
+
+}  // namespace
+
+Atmosphere::Atmosphere(const AtmosphereParameters& parameters) : params(parameters) {}
+
+uint64_t Atmosphere::key() const {
+    const int sizes[] = {TRANSMITTANCE_MU, TRANSMITTANCE_R, SCATTERING_MU,
+                         SCATTERING_MU_S, SCATTERING_R,     TRANSMITTANCE_STEPS,
+                         SCATTERING_STEPS};
+    uint64_t hash = FileCache::hash(&params, sizeof(params));
+    return FileCache::hash(sizes, sizeof(sizes), hash);
+}
+
+std::string Atmosphere::path() const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key());
+    return directory + "/" + name;
+}
+
+void Atmosphere::load() {
+    auto start = std::chrono::steady_clock::now();
+
+    cacheHit = readCache();
+    if (!cacheHit) {
+        buildTransmittance();
+        buildScattering();
+    }
+
+    std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    loadMilliseconds = elapsed.count();
+    if (!cacheHit) writeCache(loadMilliseconds);
+
+    upload();
+    // Only the GPU copies are used from here on
+    transmittance = std::vector<float>();
+    scattering = std::vector<float>();
+}
+
+bool Atmosphere::readCache() {
+    std::ifstream file(path(), std::ios::binary);
+    Header header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != MAGIC || header.version != VERSION || header.key != key())
+        return false;
+
+    transmittance.resize(TRANSMITTANCE_MU * TRANSMITTANCE_R * 3);
+    scattering.resize(SCATTERING_MU * SCATTERING_MU_S * SCATTERING_R * 4);
+    return file.read(reinterpret_cast<char*>(transmittance.data()),
+                     transmittance.size() * sizeof(float)) &&
+           file.read(reinterpret_cast<char*>(scattering.data()),
+                     scattering.size() * sizeof(float));
+}
+
+void Atmosphere::writeCache(float buildTime) const {
+    Header header = {MAGIC, VERSION, key(), buildTime, 0};
+    size_t transmittanceBytes = transmittance.size() * sizeof(float);
+    size_t scatteringBytes = scattering.size() * sizeof(float);
+    FileCache::write(path(), {{&header, sizeof(header)},
+                              {transmittance.data(), transmittanceBytes},
+                              {scattering.data(), scatteringBytes}});
+}
+
+glm::vec3 Atmosphere::opticalDepth(float r, float mu) const {
+    float length = distanceToSphere(r, mu, params.top);
+    float dt = length / TRANSMITTANCE_STEPS;
+
+    float rayleigh = 0.0f, mie = 0.0f;
+    for (int i = 0; i < TRANSMITTANCE_STEPS; i++) {
+        float t = (i + 0.5f) * dt;
+        float height = std::sqrt(r * r + t * t + 2.0f * r * t * mu) - 1.0f;
+        rayleigh += std::exp(-height / params.rayleighHeight) * dt;
+        mie += std::exp(-height / params.mieHeight) * dt;
+    }
+    return params.rayleighScattering * rayleigh + glm::vec3(params.mieExtinction * mie);
+}
+
+void Atmosphere::buildTransmittance() {
+    transmittance.resize(TRANSMITTANCE_MU * TRANSMITTANCE_R * 3);
+
+    ThreadPool::get().parallelFor(TRANSMITTANCE_R, [&](size_t row) {
+        float u = texelCoordinate(static_cast<int>(row), TRANSMITTANCE_R);
+        float r = 1.0f + u * u * (params.top - 1.0f);
+        for (int column = 0; column < TRANSMITTANCE_MU; column++) {
+            float mu = 2.0f * texelCoordinate(column, TRANSMITTANCE_MU) - 1.0f;
+            glm::vec3 depth = opticalDepth(r, mu);
+            float* texel = &transmittance[(row * TRANSMITTANCE_MU + column) * 3];
+            texel[0] = std::exp(-depth.x);
+            texel[1] = std::exp(-depth.y);
+            texel[2] = std::exp(-depth.z);
+        }
+    });
+}
+
+glm::vec3 Atmosphere::sampleTransmittance(float r, float mu) const {
+    // Inverse of the texel mapping, then bilinear between the four neighbours
+    float u = std::sqrt(std::max(r - 1.0f, 0.0f) / (params.top - 1.0f));
+    float x = (mu + 1.0f) * 0.5f * TRANSMITTANCE_MU - 0.5f;
+    float y = u * TRANSMITTANCE_R - 0.5f;
+    x = std::min(std::max(x, 0.0f), TRANSMITTANCE_MU - 1.0f);
+    y = std::min(std::max(y, 0.0f), TRANSMITTANCE_R - 1.0f);
+    int x0 = std::min(static_cast<int>(x), TRANSMITTANCE_MU - 2);
+    int y0 = std::min(static_cast<int>(y), TRANSMITTANCE_R - 2);
+    float fx = x - x0, fy = y - y0;
+
+    auto texel = [&](int column, int row) {
+        const float* t = &transmittance[(row * TRANSMITTANCE_MU + column) * 3];
+        return glm::vec3(t[0], t[1], t[2]);
+    };
+    glm::vec3 bottom = texel(x0, y0) * (1.0f - fx) + texel(x0 + 1, y0) * fx;
+    glm::vec3 top = texel(x0, y0 + 1) * (1.0f - fx) + texel(x0 + 1, y0 + 1) * fx;
+    return bottom * (1.0f - fy) + top * fy;
+}
+
+void Atmosphere::buildScattering() {
+    scattering.resize(SCATTERING_MU * SCATTERING_MU_S * SCATTERING_R * 4);
+
+    ThreadPool::get().parallelFor(SCATTERING_R, [&](size_t slice) {
+        float u = texelCoordinate(static_cast<int>(slice), SCATTERING_R);
+        float r = 1.0f + u * u * (params.top - 1.0f);
+
+        for (int row = 0; row < SCATTERING_MU_S; row++) {
+            float muS = 2.0f * texelCoordinate(row, SCATTERING_MU_S) - 1.0f;
+            for (int column = 0; column < SCATTERING_MU; column++) {
+                float mu = 2.0f * texelCoordinate(column, SCATTERING_MU) - 1.0f;
+
+                float ground = distanceToGround(r, mu);
+                float length = ground >= 0.0f ? ground
+                                              : distanceToSphere(r, mu, params.top);
+                float dt = length / SCATTERING_STEPS;
+
+                glm::vec3 rayleigh(0.0f), mie(0.0f), depth(0.0f);
+                for (int i = 0; i < SCATTERING_STEPS; i++) {
+                    float t = (i + 0.5f) * dt;
+                    float rp = std::sqrt(r * r + t * t + 2.0f * r * t * mu);
+                    float height = rp - 1.0f;
+                    float densityR = std::exp(-height / params.rayleighHeight);
+                    float densityM = std::exp(-height / params.mieHeight);
+
+                    // Optical depth from the start to the middle of this step
+                    glm::vec3 step = (params.rayleighScattering * densityR +
+                                      glm::vec3(params.mieExtinction * densityM)) *
+                                     dt;
+                    glm::vec3 middle = depth + 0.5f * step;
+                    depth += step;
+
+                    // The sun at right angles to the view plane: its zenith
+                    // cosine changes only through the zenith moving along the ray
+                    float muSp = (r * muS + t * mu * muS) / rp;
+                    if (muSp < -std::sqrt(std::max(1.0f - 1.0f / (rp * rp), 0.0f)))
+                        continue;
+
+                    glm::vec3 viewT(std::exp(-middle.x), std::exp(-middle.y),
+                                    std::exp(-middle.z));
+                    glm::vec3 light = viewT * sampleTransmittance(rp, muSp) * dt;
+                    rayleigh += light * densityR;
+                    mie += light * densityM;
+                }
+
+                rayleigh = rayleigh * params.rayleighScattering;
+                float* texel =
+                    &scattering[((slice * SCATTERING_MU_S + row) * SCATTERING_MU +
+                                 column) *
+                                4];
+                texel[0] = rayleigh.x;
+                texel[1] = rayleigh.y;
+                texel[2] = rayleigh.z;
+                texel[3] = mie.x * params.mieScattering;
+            }
+        }
+    });
+}
+
+void Atmosphere::upload() {
+    if (transmittanceTexture == 0) {
+        glGenTextures(1, &transmittanceTexture);
+        glGenTextures(1, &scatteringTexture);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, transmittanceTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, TRANSMITTANCE_MU, TRANSMITTANCE_R, 0,
+                 GL_RGB, GL_FLOAT, transmittance.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindTexture(GL_TEXTURE_3D, scatteringTexture);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA16F, SCATTERING_MU, SCATTERING_MU_S,
+                 SCATTERING_R, 0, GL_RGBA, GL_FLOAT, scattering.data());
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Atmosphere::add(const glm::vec3& center, float planetRadius) {
+    spheres.push_back(glm::vec4(center, planetRadius));
+}
+
+void Atmosphere::initQuad() {
+    // Quad corners in units of the billboard half-size, drawn as a strip
+    const GLfloat corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+    glGenVertexArrays(1, &VAO);
+    GLState::get().bindVertexArray(VAO);
+    glGenBuffers(1, &quadVBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Atmosphere::render(const Shader& shader, const glm::vec3& sunPosition,
+                        const glm::vec3& sunColor) {
+    if (spheres.empty() || scatteringTexture == 0) return;
+    if (VAO == 0) initQuad();
+
+    if (!stream.write(spheres.data(), spheres.size() * sizeof(glm::vec4))) return;
+
+    GLState::get().bindVertexArray(VAO);
+    if (stream.generation() != streamGeneration) {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer());
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribDivisor(1, 1);
+        streamGeneration = stream.generation();
+    }
+
+    glActiveTexture(GL_TEXTURE0 + TRANSMITTANCE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, transmittanceTexture);
+    glActiveTexture(GL_TEXTURE0 + SCATTERING_UNIT);
+    glBindTexture(GL_TEXTURE_3D, scatteringTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("transmittanceTable", TRANSMITTANCE_UNIT);
+    shader.setInt("scatteringTable", SCATTERING_UNIT);
+    shader.setFloat("atmosphereTop", params.top);
+    shader.setVec3("rayleighScattering", params.rayleighScattering);
+    shader.setFloat("mieG", params.mieG);
+    shader.setVec3("sunPosition", sunPosition);
+    shader.setVec3("sunRadiance", sunColor * intensity);
+
+    GLsizei count = static_cast<GLsizei>(spheres.size());
+    GLint first = stream.first();
+    if (first == 0)
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    else
+        GLExt::DrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, count, first);
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,73 @@
+#include "Renderer/BodyLabels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "imgui.h"
+
+void BodyLabels::begin(const glm::mat4& view, const glm::mat4& projection,
+                       const glm::vec3& cameraPos, float width, float height) {
+    viewProjection = projection * view;
+    camera = cameraPos;
+    this->width = width;
+    this->height = height;
+
+    int newColumns = std::max(1, static_cast<int>(std::ceil(width / cellWidth)));
+    int newRows = std::max(1, static_cast<int>(std::ceil(height / cellHeight)));
+    if (newColumns != columns || newRows != rows || frame == UINT32_MAX) {
+        columns = newColumns;
+        rows = newRows;
+        cellFrame.assign(columns * rows, 0);
+        cellLabel.assign(columns * rows, 0);
+        frame = 0;
+    }
+    // Cells claimed in an earlier frame read as empty
+    frame++;
+
+    survivors.clear();
+    candidates = 0;
+}
+
+void BodyLabels::add(const glm::vec3& position, float priority, const char* name,
+                     int number) {
+    candidates++;
+
+    glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+    if (clip.w <= 0.0f) return;
+    float ndcX = clip.x / clip.w, ndcY = clip.y / clip.w;
+    if (ndcX < -1.0f || ndcX >= 1.0f || ndcY <= -1.0f || ndcY > 1.0f) return;
+
+    // Screen pixels, y down as ImGui draws
+    float x = (ndcX * 0.5f + 0.5f) * width;
+    float y = (0.5f - ndcY * 0.5f) * height;
+    int column = std::min(static_cast<int>(x / cellWidth), columns - 1);
+    int row = std::min(static_cast<int>(y / cellHeight), rows - 1);
+    int cell = row * columns + column;
+
+    Label label = {x, y, priority, glm::length(position - camera), name, number};
+    if (cellFrame[cell] != frame) {
+        cellFrame[cell] = frame;
+        cellLabel[cell] = static_cast<uint32_t>(survivors.size());
+        survivors.push_back(label);
+    } else if (priority > survivors[cellLabel[cell]].priority) {
+        survivors[cellLabel[cell]] = label;
+    }
+}
+
+void BodyLabels::draw(ImDrawList* drawList) {
+    const ImU32 marker = IM_COL32(255, 255, 255, 160);
+    const ImU32 text = IM_COL32(230, 230, 230, 255);
+    char buffer[96];
+    for (const Label& label : survivors) {
+        if (label.number >= 0)
+            std::snprintf(buffer, sizeof(buffer), "%s %d  %.0f", label.name,
+                          label.number, label.distance);
+        else
+            std::snprintf(buffer, sizeof(buffer), "%s  %.0f", label.name,
+                          label.distance);
+
+        drawList->AddCircle(ImVec2(label.x, label.y), 3.0f, marker, 8);
+        drawList->AddText(ImVec2(label.x + 6.0f, label.y - 6.0f), text, buffer);
+    }
+}
@@ -0,0 +1,379 @@
+#include "Renderer/BodyRenderer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
+#include "utils/ThreadPool.h"
+
+BodyRenderer::BodyRenderer() {
+    for (unsigned int lod = 0; lod < LOD_COUNT; lod++) {
+        lodMeshes[lod] = &MeshCache::get().icosphere(lodSubdivisions(lod));
+        lodErrors[lod] = Geometry::icosphereError(lodSubdivisions(lod));
+    }
+}
+
+void BodyRenderer::setView(const Camera& camera, const glm::mat4& view,
+                           const glm::mat4& projection, float viewportHeight) {
+    viewPosition = camera.Position;
+    viewFrustum = Frustum(projection * view);
+    // projection[1][1] is cot(fov / 2): a unit length at unit distance spans
+    // projection[1][1] half-viewports
+    pixelScale = projection[1][1] * viewportHeight * 0.5f;
+}
+
+void BodyRenderer::begin() {
+    for (auto& entry : batches) entry.second.instances.clear();
+    impostors.instances.clear();
+    points.clear();
+    resolved.clear();
+    culled = 0;
+    for (unsigned int lod = 0; lod < LOD_COUNT; lod++) lodInstances[lod] = 0;
+    instances = 0;
+}
+
+float BodyRenderer::screenRadius(const glm::vec3& center, float radius) const {
+    float distance = glm::length(center - viewPosition);
+    if (distance <= radius) return std::numeric_limits<float>::infinity();
+
+    return radius * pixelScale / distance;
+}
+
+unsigned int BodyRenderer::selectLod(float screenRadius) const {
+    // Walk from the coarsest level towards the finest until the error fits
+    unsigned int lod = LOD_COUNT - 1;
+    while (lod > 0 && screenRadius * lodErrors[lod] > pixelError) lod--;
+    return lod;
+}
+
+BodyRenderer::Tier BodyRenderer::selectTier(float screenRadius) const {
+    if (screenRadius < pointRadius) return TIER_POINT;
+    if (screenRadius < impostorRadius) return TIER_IMPOSTOR;
+    return TIER_MESH;
+}
+
+void BodyRenderer::submit(const glm::vec3& center, float radius,
+                          const BodyInstance& instance) {
+    float pixels = screenRadius(center, radius);
+    Tier tier = selectTier(pixels);
+
+    if (tier == TIER_POINT) {
+        points.push_back(PointSprite{center, radius, packColor(instance.color)});
+        instances++;
+        return;
+    }
+
+    submitInstance(tier, pixels, instance);
+}
+
+void BodyRenderer::submitInstance(Tier tier, float screenRadius,
+                                  const BodyInstance& instance) {
+    if (tier == TIER_IMPOSTOR) {
+        impostors.instances.push_back(instance);
+        instances++;
+        return;
+    }
+
+    unsigned int lod = selectLod(screenRadius);
+    lodInstances[lod]++;
+    submit(*lodMeshes[lod], instance);
+}
+
+void BodyRenderer::submitSpheres(const glm::vec3* centers, const float* radii,
+                                 size_t count, const glm::vec4& color,
+                                 const glm::vec4& material) {
+    const size_t CHUNK = 16384;
+    size_t chunks = (count + CHUNK - 1) / CHUNK;
+    resolved.clear();
+    if (chunks == 0) return;
+
+    sphereTiers.resize(count);
+    chunkPoints.assign(chunks + 1, 0);
+
+    std::vector<size_t> chunkCulled(chunks, 0);
+
+    // Pass 1: cull and classify every sphere and count the points of each chunk
+    ThreadPool::get().parallelFor(chunks, [&](size_t chunk) {
+        size_t end = std::min(count, (chunk + 1) * CHUNK);
+        size_t pointsInChunk = 0;
+        for (size_t i = chunk * CHUNK; i < end; i++) {
+            if (!viewFrustum.intersects(centers[i], radii[i])) {
+                sphereTiers[i] = TIER_CULLED;
+                chunkCulled[chunk]++;
+                continue;
+            }
+            sphereTiers[i] = selectTier(screenRadius(centers[i], radii[i]));
+            if (sphereTiers[i] == TIER_POINT) pointsInChunk++;
+        }
+        chunkPoints[chunk + 1] = pointsInChunk;
+    });
+    for (size_t n : chunkCulled) culled += n;
+
+    size_t base = points.size();
+    for (size_t chunk = 0; chunk < chunks; chunk++)
+        chunkPoints[chunk + 1] += chunkPoints[chunk];
+    points.resize(base + chunkPoints[chunks]);
+
+    // Pass 2: every chunk writes its points into its own range
+    GLuint packed = packColor(color);
+    ThreadPool::get().parallelFor(chunks, [&](size_t chunk) {
+        size_t end = std::min(count, (chunk + 1) * CHUNK);
+        PointSprite* out = &points[base + chunkPoints[chunk]];
+        for (size_t i = chunk * CHUNK; i < end; i++) {
+            if (sphereTiers[i] == TIER_POINT)
+                *out++ = PointSprite{centers[i], radii[i], packed};
+        }
+    });
+    instances += chunkPoints[chunks];
+
+    // The remaining spheres are close enough to be few
+    for (size_t i = 0; i < count; i++) {
+        if (sphereTiers[i] == TIER_POINT || sphereTiers[i] == TIER_CULLED) continue;
+        resolved.push_back(static_cast<uint32_t>(i));
+
+        BodyInstance instance;
+        instance.model = glm::scale(glm::translate(glm::mat4(1.0f), centers[i]),
+                                    glm::vec3(radii[i]));
+        instance.color = color;
+        instance.material = material;
+        submitInstance(static_cast<Tier>(sphereTiers[i]),
+                       screenRadius(centers[i], radii[i]), instance);
+    }
+}
+
+void BodyRenderer::submit(const Mesh& mesh, const BodyInstance& instance) {
+    Batch& batch = batches[&mesh];
+    if (batch.VAO == 0) initBatch(mesh, batch);
+
+    batch.instances.push_back(instance);
+    instances++;
+}
+
+void BodyRenderer::render() {
+    drawCalls = 0;
+    triangles = 0;
+
+    for (auto& entry : batches) {
+        const Mesh& mesh = *entry.first;
+        Batch& batch = entry.second;
+        if (batch.instances.empty()) continue;
+
+        GLsizei count = uploadInstances(batch);
+        if (count == 0) continue;
+
+        GLState::get().bindVertexArray(batch.VAO);
+        GLint first = batch.stream.first();
+        if (first == 0)
+            glDrawElementsInstanced(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0,
+                                    count);
+        else
+            GLExt::DrawElementsInstancedBaseInstance(
+                GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, 0, count, first);
+        drawCalls++;
+        triangles += (mesh.indexCount / 3) * batch.instances.size();
+    }
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::renderImpostors() {
+    if (impostors.instances.empty()) return;
+    if (impostors.VAO == 0) initImpostors();
+
+    GLsizei count = uploadInstances(impostors);
+    if (count == 0) return;
+
+    GLState::get().bindVertexArray(impostors.VAO);
+    GLint first = impostors.stream.first();
+    if (first == 0)
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+    else
+        GLExt::DrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, count, first);
+    drawCalls++;
+    triangles += 2 * impostors.instances.size();
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::renderPoints(const Shader& shader) {
+    if (points.empty()) return;
+    if (pointVAO == 0) initPoints();
+
+    // One upload per frame into the next region of the stream
+    GLsizeiptr bytes = points.size() * sizeof(PointSprite);
+    if (!pointStream.write(points.data(), bytes)) return;
+
+    shader.setFloat("pixelScale", pixelScale);
+
+    if (pointStream.generation() != pointGeneration) {
+        setPointAttributes(pointVAO, pointStream.buffer());
+        pointGeneration = pointStream.generation();
+    }
+    GLState::get().bindVertexArray(pointVAO);
+    glDrawArrays(GL_POINTS, pointStream.first(), static_cast<GLsizei>(points.size()));
+    drawCalls++;
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLsizei BodyRenderer::uploadInstances(Batch& batch) {
+    // Refill the instance stream once per batch per frame
+    GLsizeiptr bytes = batch.instances.size() * sizeof(BodyInstance);
+    if (!batch.stream.write(batch.instances.data(), bytes)) return 0;
+
+    if (batch.stream.generation() != batch.streamGeneration) {
+        setInstanceAttributes(batch.VAO, batch.stream.buffer());
+        batch.streamGeneration = batch.stream.generation();
+    }
+
+    return static_cast<GLsizei>(batch.instances.size());
+}
+
+void BodyRenderer::initImpostors() {
+    // Quad corners in units of the billboard half-size, drawn as a strip
+    const GLfloat corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+
+    if (GLExt::directStateAccess()) {
+        GLExt::CreateBuffers(1, &quadVBO);
+        GLExt::NamedBufferStorage(quadVBO, sizeof(corners), corners, 0);
+
+        GLExt::CreateVertexArrays(1, &impostors.VAO);
+        GLExt::VertexArrayVertexBuffer(impostors.VAO, 0, quadVBO, 0,
+                                       2 * sizeof(GLfloat));
+        GLExt::vertexAttribute(impostors.VAO, 0, 0, 2, GL_FLOAT, GL_FALSE, 0);
+        formatInstanceAttributes(impostors.VAO);
+        return;
+    }
+
+    glGenVertexArrays(1, &impostors.VAO);
+    GLState::get().bindVertexArray(impostors.VAO);
+    glGenBuffers(1, &quadVBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::initPoints() {
+    // Attributes are pointed at the stream once it has a buffer
+    if (!GLExt::directStateAccess()) {
+        glGenVertexArrays(1, &pointVAO);
+        return;
+    }
+
+    GLExt::CreateVertexArrays(1, &pointVAO);
+    GLExt::vertexAttribute(pointVAO, 0, 0, 4, GL_FLOAT, GL_FALSE,
+                           offsetof(PointSprite, position));
+    GLExt::vertexAttribute(pointVAO, 1, 0, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                           offsetof(PointSprite, color));
+}
+
+void BodyRenderer::setPointAttributes(GLuint VAO, GLuint pointVBO) {
+    if (GLExt::directStateAccess()) {
+        GLExt::VertexArrayVertexBuffer(VAO, 0, pointVBO, 0, sizeof(PointSprite));
+        return;
+    }
+
+    GLState::get().bindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, pointVBO);
+    // Position and radius
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(PointSprite),
+                          (void*)offsetof(PointSprite, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PointSprite),
+                          (void*)offsetof(PointSprite, color));
+    glEnableVertexAttribArray(1);
+}
+
+GLuint BodyRenderer::packColor(const glm::vec4& color) {
+    glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+    // Little-endian RGBA8, matching GL_UNSIGNED_BYTE component order in memory
+    return (GLuint)c.r | ((GLuint)c.g << 8) | ((GLuint)c.b << 16) |
+           ((GLuint)c.a << 24);
+}
+
+void BodyRenderer::initBatch(const Mesh& mesh, Batch& batch) {
+    // A VAO of our own: the mesh's buffers plus, once uploaded, this batch's
+    // instance stream
+    if (GLExt::directStateAccess()) {
+        GLExt::CreateVertexArrays(1, &batch.VAO);
+        GLExt::VertexArrayVertexBuffer(batch.VAO, 0, mesh.VBO, 0, 6 * sizeof(GLfloat));
+        GLExt::vertexAttribute(batch.VAO, 0, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        GLExt::vertexAttribute(batch.VAO, 1, 0, 3, GL_FLOAT, GL_FALSE,
+                               3 * sizeof(GLfloat));
+        GLExt::VertexArrayElementBuffer(batch.VAO, mesh.EBO);
+        formatInstanceAttributes(batch.VAO);
+        return;
+    }
+
+    glGenVertexArrays(1, &batch.VAO);
+    GLState::get().bindVertexArray(batch.VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+                          (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+
+    GLState::get().bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void BodyRenderer::formatInstanceAttributes(GLuint VAO) {
+    // Binding 1 advances once per instance; the stream is attached to it later
+    for (GLuint column = 0; column < 4; column++)
+        GLExt::vertexAttribute(VAO, 2 + column, 1, 4, GL_FLOAT, GL_FALSE,
+                               offsetof(BodyInstance, model) +
+                                   column * sizeof(glm::vec4));
+    GLExt::vertexAttribute(VAO, 6, 1, 4, GL_FLOAT, GL_FALSE,
+                           offsetof(BodyInstance, color));
+    GLExt::vertexAttribute(VAO, 7, 1, 4, GL_FLOAT, GL_FALSE,
+                           offsetof(BodyInstance, material));
+    GLExt::vertexAttribute(VAO, 8, 1, 4, GL_FLOAT, GL_FALSE,
+                           offsetof(BodyInstance, surface));
+    GLExt::VertexArrayBindingDivisor(VAO, 1, 1);
+}
+
+void BodyRenderer::setInstanceAttributes(GLuint VAO, GLuint instanceVBO) {
+    if (GLExt::directStateAccess()) {
+        GLExt::VertexArrayVertexBuffer(VAO, 1, instanceVBO, 0, sizeof(BodyInstance));
+        return;
+    }
+
+    GLState::get().bindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint column = 0; column < 4; column++) {
+        glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance),
+                              (void*)(offsetof(BodyInstance, model) +
+                                      column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(2 + column);
+        glVertexAttribDivisor(2 + column, 1);
+    }
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance),
+                          (void*)offsetof(BodyInstance, color));
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(6, 1);
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance),
+                          (void*)offsetof(BodyInstance, material));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+    glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(BodyInstance),
+                          (void*)offsetof(BodyInstance, surface));
+    glEnableVertexAttribArray(8);
+    glVertexAttribDivisor(8, 1);
+}
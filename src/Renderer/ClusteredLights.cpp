@@ -0,0 +1,197 @@
+#include "Renderer/ClusteredLights.h"
+
+#include <algorithm>
+#include <cmath>
+
+static_assert(sizeof(ClusterLight) == 32, "ClusterLight must be two RGBA32F texels");
+
+// Ranges bound to a uniform block must start on the implementation's alignment
+static GLsizeiptr alignedBlockSize(GLsizeiptr size) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment < 1) alignment = 1;
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+ClusteredLights::ClusteredLights()
+    : lightStream(GL_TEXTURE_BUFFER, sizeof(ClusterLight)),
+      rangeStream(GL_TEXTURE_BUFFER, 2 * sizeof(GLuint)),
+      indexStream(GL_TEXTURE_BUFFER, sizeof(GLuint)),
+      blockStream(GL_UNIFORM_BUFFER, alignedBlockSize(sizeof(ClusterData))) {
+    glGenTextures(3, textures);
+    ranges.resize(CLUSTER_COUNT * 2);
+}
+
+void ClusteredLights::add(const glm::vec3& position, const glm::vec3& color,
+                          float range, bool shadowed) {
+    if (range <= 0.0f) return;
+    lights.push_back(ClusterLight{position, range, color, shadowed ? 1.0f : 0.0f});
+}
+
+ClusteredLights::Bounds ClusteredLights::froxelBounds(const ClusterLight& light,
+                                                      const glm::mat4& view,
+                                                      const glm::mat4& projection,
+                                                      float near,
+                                                      float sliceScale) const {
+    Bounds b = {0, GRID_X - 1, 0, GRID_Y - 1, 0, GRID_Z - 1, false};
+
+    glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+    float r = light.range;
+    // View space looks down -z; depths are positive distances along it
+    float nearDepth = -center.z - r;
+    float farDepth = -center.z + r;
+    if (farDepth < near) return b;
+
+    auto slice = [&](float depth) {
+        float s = std::floor(std::log(std::max(depth, near) / near) * sliceScale);
+        return static_cast<unsigned int>(
+            std::min(std::max(s, 0.0f), static_cast<float>(GRID_Z - 1)));
+    };
+    b.z0 = slice(nearDepth);
+    b.z1 = slice(farDepth);
+    b.visible = true;
+
+    // The camera is inside the light's range: every tile
+    if (glm::length(center) <= r) return b;
+
+    // Screen extent of the view-space box around the sphere. Corners in front
+    // of the near plane are pulled onto it, which only widens the extent.
+    float loX = 1.0f, loY = 1.0f, hiX = -1.0f, hiY = -1.0f;
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 p = center + glm::vec3(corner & 1 ? r : -r, corner & 2 ? r : -r,
+                                         corner & 4 ? r : -r);
+        p.z = std::min(p.z, -near);
+        glm::vec4 clip = projection * glm::vec4(p, 1.0f);
+        float x = clip.x / clip.w, y = clip.y / clip.w;
+        loX = std::min(loX, x);
+        loY = std::min(loY, y);
+        hiX = std::max(hiX, x);
+        hiY = std::max(hiY, y);
+    }
+    loX = std::max(loX, -1.0f);
+    loY = std::max(loY, -1.0f);
+    hiX = std::min(hiX, 1.0f);
+    hiY = std::min(hiY, 1.0f);
+    if (loX >= hiX || loY >= hiY) {
+        b.visible = false;
+        return b;
+    }
+
+    auto tile = [](float ndc, unsigned int count) {
+        float t = std::floor((ndc * 0.5f + 0.5f) * count);
+        return static_cast<unsigned int>(
+            std::min(std::max(t, 0.0f), static_cast<float>(count - 1)));
+    };
+    b.x0 = tile(loX, GRID_X);
+    b.x1 = tile(hiX, GRID_X);
+    b.y0 = tile(loY, GRID_Y);
+    b.y1 = tile(hiY, GRID_Y);
+    return b;
+}
+
+void ClusteredLights::build(const glm::mat4& view, const glm::mat4& projection,
+                            float near, float far, int viewportWidth,
+                            int viewportHeight) {
+    // Strongest first, so full froxels drop the weakest lights
+    std::stable_sort(lights.begin(), lights.end(),
+                     [](const ClusterLight& a, const ClusterLight& b) {
+                         return a.range > b.range;
+                     });
+
+    float sliceScale = GRID_Z / std::log(far / near);
+
+    bounds.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); i++)
+        bounds[i] = froxelBounds(lights[i], view, projection, near, sliceScale);
+
+    // Pass 1: count the (capped) lights of every froxel
+    std::fill(ranges.begin(), ranges.end(), 0);
+    for (const Bounds& b : bounds) {
+        if (!b.visible) continue;
+        for (unsigned int z = b.z0; z <= b.z1; z++)
+            for (unsigned int y = b.y0; y <= b.y1; y++)
+                for (unsigned int x = b.x0; x <= b.x1; x++) {
+                    GLuint& count = ranges[((z * GRID_Y + y) * GRID_X + x) * 2 + 1];
+                    if (count < MAX_CLUSTER_LIGHTS) count++;
+                }
+    }
+
+    GLuint total = 0;
+    maxClusterLights = 0;
+    for (unsigned int c = 0; c < CLUSTER_COUNT; c++) {
+        ranges[c * 2] = total;
+        total += ranges[c * 2 + 1];
+        maxClusterLights = std::max(maxClusterLights, ranges[c * 2 + 1]);
+        // Reused as the fill cursor below
+        ranges[c * 2 + 1] = 0;
+    }
+
+    // Pass 2: fill the lists
+    indices.resize(total);
+    for (size_t i = 0; i < bounds.size(); i++) {
+        const Bounds& b = bounds[i];
+        if (!b.visible) continue;
+        for (unsigned int z = b.z0; z <= b.z1; z++)
+            for (unsigned int y = b.y0; y <= b.y1; y++)
+                for (unsigned int x = b.x0; x <= b.x1; x++) {
+                    GLuint* range = &ranges[((z * GRID_Y + y) * GRID_X + x) * 2];
+                    if (range[1] == MAX_CLUSTER_LIGHTS) continue;
+                    indices[range[0] + range[1]++] = static_cast<GLuint>(i);
+                }
+    }
+
+    upload(lightStream, 0, GL_RGBA32F, lights.data(),
+           lights.size() * sizeof(ClusterLight));
+    upload(rangeStream, 1, GL_RG32UI, ranges.data(), ranges.size() * sizeof(GLuint));
+    upload(indexStream, 2, GL_R32UI, indices.data(), indices.size() * sizeof(GLuint));
+
+    ClusterData data = {
+        {GRID_X, GRID_Y, GRID_Z, static_cast<GLuint>(lights.size())},
+        {static_cast<GLuint>(lightStream.first()),
+         static_cast<GLuint>(rangeStream.first()),
+         static_cast<GLuint>(indexStream.first()), 0},
+        {near, sliceScale, static_cast<float>(viewportWidth) / GRID_X,
+         static_cast<float>(viewportHeight) / GRID_Y}};
+    if (blockStream.write(&data, sizeof(data)))
+        glBindBufferRange(GL_UNIFORM_BUFFER, BLOCK_BINDING, blockStream.buffer(),
+                          blockStream.offset(), sizeof(data));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ClusteredLights::upload(StreamBuffer& stream, int list, GLenum format,
+                             const void* data, GLsizeiptr bytes) {
+    // Empty lists still need storage behind the texture
+    static const GLuint empty[4] = {};
+    if (bytes == 0) {
+        data = empty;
+        bytes = sizeof(empty);
+    }
+    stream.write(data, bytes);
+
+    if (stream.generation() != generations[list]) {
+        glBindTexture(GL_TEXTURE_BUFFER, textures[list]);
+        glTexBuffer(GL_TEXTURE_BUFFER, format, stream.buffer());
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        generations[list] = stream.generation();
+    }
+}
+
+void ClusteredLights::bind() {
+    const GLint units[3] = {LIGHT_UNIT, RANGE_UNIT, INDEX_UNIT};
+    for (int list = 0; list < 3; list++) {
+        glActiveTexture(GL_TEXTURE0 + units[list]);
+        glBindTexture(GL_TEXTURE_BUFFER, textures[list]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void ClusteredLights::attach(const Shader& shader) {
+    GLuint block = glGetUniformBlockIndex(shader.ID, "Clusters");
+    if (block != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, block, BLOCK_BINDING);
+
+    shader.use();
+    shader.setInt("clusterLights", LIGHT_UNIT);
+    shader.setInt("clusterRanges", RANGE_UNIT);
+    shader.setInt("clusterIndices", INDEX_UNIT);
+}
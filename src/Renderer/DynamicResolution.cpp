@@ -0,0 +1,90 @@
+#include "Renderer/DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::resize(int width, int height) {
+    if (width == this->width && height == this->height && FBO != 0) return;
+    this->width = width;
+    this->height = height;
+
+    if (FBO == 0) {
+        glGenFramebuffers(1, &FBO);
+        glGenRenderbuffers(1, &colorBuffer);
+        glGenRenderbuffers(1, &depthBuffer);
+        glGenQueries(QUERY_COUNT, queries);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                              colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                              depthBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::begin() {
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, sceneWidth(), sceneHeight());
+
+    queryScales[frames % QUERY_COUNT] = currentScale;
+    glBeginQuery(GL_TIME_ELAPSED, queries[frames % QUERY_COUNT]);
+}
+
+void DynamicResolution::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    frames++;
+
+    // The oldest query is the one begin() reuses next, so read it now if it is in.
+    // A result is read once, as begin() then reissues the query.
+    bool measured = false;
+    float issuedScale = 0.0f;
+    if (frames >= QUERY_COUNT) {
+        GLuint query = queries[frames % QUERY_COUNT];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+            measuredTime = static_cast<float>(nanoseconds) * 1.0e-6f;
+            issuedScale = queryScales[frames % QUERY_COUNT];
+            measured = true;
+        }
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+    glBlitFramebuffer(0, 0, sceneWidth(), sceneHeight(), 0, 0, width, height,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, width, height);
+
+    if (!enabled)
+        currentScale = maxScale;
+    else if (measured)
+        adapt(measuredTime, issuedScale);
+}
+
+int DynamicResolution::scaled(int size) const {
+    return std::max(1, static_cast<int>(std::lround(size * currentScale)));
+}
+
+void DynamicResolution::adapt(float time, float issuedScale) {
+    if (time <= 0.0f || issuedScale <= 0.0f) return;
+
+    // Dead band, so the scale settles instead of hunting around the target
+    float ratio = targetTime / time;
+    if (ratio > 0.9f && ratio < 1.1f) return;
+
+    // Move part of the way each measurement; the one just read was drawn a few
+    // frames ago, at a scale the current one may already have moved from
+    float desired = issuedScale * std::sqrt(ratio);
+    currentScale += (desired - currentScale) * 0.25f;
+    currentScale = std::min(maxScale, std::max(minScale, currentScale));
+}
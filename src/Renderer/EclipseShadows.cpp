@@ -0,0 +1,94 @@
+#include "Renderer/EclipseShadows.h"
+
+#include <algorithm>
+
+EclipseShadows::EclipseShadows() : stream(GL_TEXTURE_BUFFER, sizeof(glm::vec4)) {
+    glGenTextures(1, &texture);
+}
+
+void EclipseShadows::begin(const glm::vec3& lightPosition, float lightRadius) {
+    light = lightPosition;
+    this->lightRadius = lightRadius;
+    occluders.clear();
+    lists.clear();
+    candidates = 0;
+}
+
+int EclipseShadows::addOccluder(const glm::vec3& center, float radius) {
+    occluders.push_back(glm::vec4(center, radius));
+    return static_cast<int>(occluders.size()) - 1;
+}
+
+float EclipseShadows::addReceiver(const glm::vec3& center, float radius, int self) {
+    glm::vec3 axis = center - light;
+    float length = glm::length(axis);
+    if (length <= lightRadius + radius) return 0.0f;
+    glm::vec3 direction = axis / length;
+
+    scratch.clear();
+    for (int i = 0; i < static_cast<int>(occluders.size()); i++) {
+        if (i == self) continue;
+        glm::vec3 occluder = glm::vec3(occluders[i]);
+        float occluderRadius = occluders[i].w;
+
+        // Along the axis, the occluder must overlap the span from the light to
+        // the receiver's far side
+        glm::vec3 offset = occluder - light;
+        float t = glm::dot(offset, direction);
+        if (t + occluderRadius <= 0.0f || t - occluderRadius >= length + radius)
+            continue;
+
+        // Across it, the hull of the two spheres narrows linearly from one
+        // radius to the other
+        float along = std::min(std::max(t / length, 0.0f), 1.0f);
+        float hullRadius = lightRadius + (radius - lightRadius) * along;
+        float across = glm::length(offset - t * direction);
+        if (across >= hullRadius + occluderRadius) continue;
+
+        float gap = std::max(glm::length(occluder - center) - radius, occluderRadius);
+        scratch.push_back(Candidate{occluderRadius / gap, i});
+    }
+    candidates += scratch.size();
+    if (scratch.empty()) return 0.0f;
+
+    // The largest occluders matter most
+    size_t kept = std::min(scratch.size(), static_cast<size_t>(MAX_OCCLUDERS));
+    std::partial_sort(scratch.begin(), scratch.begin() + kept, scratch.end(),
+                      [](const Candidate& a, const Candidate& b) {
+                          return a.size > b.size;
+                      });
+
+    size_t list = lists.size() / MAX_OCCLUDERS;
+    for (size_t i = 0; i < MAX_OCCLUDERS; i++)
+        lists.push_back(i < kept ? occluders[scratch[i].occluder] : glm::vec4(0.0f));
+    return static_cast<float>(list + 1);
+}
+
+void EclipseShadows::upload() {
+    // The texture needs storage even when no list was built
+    glm::vec4 empty(0.0f);
+    const void* data = lists.empty() ? &empty : lists.data();
+    GLsizeiptr bytes =
+        lists.empty() ? sizeof(empty) : lists.size() * sizeof(glm::vec4);
+    stream.write(data, bytes);
+
+    if (stream.generation() != generation) {
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, stream.buffer());
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        generation = stream.generation();
+    }
+}
+
+void EclipseShadows::bind(const Shader& shader) const {
+    glActiveTexture(GL_TEXTURE0 + OCCLUDER_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+    shader.setInt("occluderBase", stream.first());
+    shader.setFloat("lightRadius", lightRadius);
+}
+
+void EclipseShadows::attach(const Shader& shader) {
+    shader.use();
+    shader.setInt("occluders", OCCLUDER_UNIT);
+}
@@ -0,0 +1,147 @@
+#include "Renderer/FrameCapture.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+FrameCapture::~FrameCapture() { close(); }
+
+bool FrameCapture::open(const std::string& destination, GLuint framebuffer,
+                        int width, int height) {
+    close();
+
+    pipe = !destination.empty() && destination[0] == '|';
+    output = pipe ? popen(destination.c_str() + 1, "w")
+                  : std::fopen(destination.c_str(), "wb");
+    if (output == nullptr) return false;
+
+    source = framebuffer;
+    this->width = width;
+    this->height = height;
+    frameBytes = static_cast<size_t>(width) * height * 4;
+
+    glGenBuffers(RING, PBOs);
+    for (GLuint PBO : PBOs) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, PBO);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    captured = 0;
+    written = 0;
+    closing = false;
+    writer = std::thread(&FrameCapture::writeLoop, this);
+    return true;
+}
+
+void FrameCapture::close() {
+    if (output == nullptr) return;
+
+    // Oldest first: the slot capture() would reuse next
+    for (int i = 0; i < RING; i++) collect((captured + i) % RING);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    ready.notify_one();
+    writer.join();
+
+    glDeleteBuffers(RING, PBOs);
+    if (pipe)
+        pclose(output);
+    else
+        std::fclose(output);
+    output = nullptr;
+}
+
+void FrameCapture::capture() {
+    if (output == nullptr) return;
+
+    int slot = captured % RING;
+    // This slot's previous frame was queued RING frames ago and is done by now
+    collect(slot);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glReadBuffer(source == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, PBOs[slot]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    captured++;
+}
+
+void FrameCapture::collect(int slot) {
+    GLsync fence = fences[slot];
+    if (fence == nullptr) return;
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+    glDeleteSync(fence);
+    fences[slot] = nullptr;
+
+    std::vector<unsigned char> frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return queue.size() < MAX_QUEUED; });
+        if (!spare.empty()) {
+            frame = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    frame.resize(frameBytes);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, PBOs[slot]);
+    const void* pixels =
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+    if (pixels != nullptr) {
+        std::memcpy(frame.data(), pixels, frameBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (pixels == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(frame));
+    }
+    ready.notify_one();
+}
+
+unsigned long FrameCapture::framesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written;
+}
+
+void FrameCapture::writeLoop() {
+    size_t rowBytes = static_cast<size_t>(width) * 4;
+    std::vector<unsigned char> flipped(frameBytes);
+
+    while (true) {
+        std::vector<unsigned char> frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return closing || !queue.empty(); });
+            if (queue.empty()) return;
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        drained.notify_one();
+
+        // GL rows run bottom-up, video rows top-down
+        for (int y = 0; y < height; y++)
+            std::memcpy(&flipped[y * rowBytes], &frame[(height - 1 - y) * rowBytes],
+                        rowBytes);
+        std::fwrite(flipped.data(), 1, frameBytes, output);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(frame));
+        written++;
+    }
+}
@@ -0,0 +1,28 @@
+#include "Renderer/FrameUniforms.h"
+
+#include <cstddef>
+
+#include "Renderer/Shader.h"
+
+static_assert(sizeof(FrameData) == 208, "FrameData must match the std140 Frame block");
+// logDepth fills the padding after lightSpecular, as in frame.glsl
+static_assert(offsetof(FrameData, logDepth) == 204,
+              "logDepth must follow lightSpecular");
+
+// Ranges bound to a uniform block must start on the implementation's alignment
+static GLsizeiptr alignedFrameSize() {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment < 1) alignment = 1;
+    return (sizeof(FrameData) + alignment - 1) / alignment * alignment;
+}
+
+FrameUniforms::FrameUniforms() : stream(GL_UNIFORM_BUFFER, alignedFrameSize()) {}
+
+void FrameUniforms::upload(const FrameData& data) {
+    if (!stream.write(&data, sizeof(FrameData))) return;
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, Shader::FRAME_BLOCK_BINDING, stream.buffer(),
+                      stream.offset(), sizeof(FrameData));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
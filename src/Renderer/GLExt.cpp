@@ -0,0 +1,94 @@
+#include "Renderer/GLExt.h"
+
+namespace GLExt {
+
+PFNGLGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC ProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+PFNGLCREATEBUFFERSPROC CreateBuffers = nullptr;
+PFNGLNAMEDBUFFERSTORAGEPROC NamedBufferStorage = nullptr;
+PFNGLNAMEDBUFFERSUBDATAPROC NamedBufferSubData = nullptr;
+PFNGLMAPNAMEDBUFFERRANGEPROC MapNamedBufferRange = nullptr;
+PFNGLUNMAPNAMEDBUFFERPROC UnmapNamedBuffer = nullptr;
+PFNGLCREATEVERTEXARRAYSPROC CreateVertexArrays = nullptr;
+PFNGLVERTEXARRAYVERTEXBUFFERPROC VertexArrayVertexBuffer = nullptr;
+PFNGLVERTEXARRAYELEMENTBUFFERPROC VertexArrayElementBuffer = nullptr;
+PFNGLVERTEXARRAYATTRIBFORMATPROC VertexArrayAttribFormat = nullptr;
+PFNGLVERTEXARRAYATTRIBBINDINGPROC VertexArrayAttribBinding = nullptr;
+PFNGLENABLEVERTEXARRAYATTRIBPROC EnableVertexArrayAttrib = nullptr;
+PFNGLVERTEXARRAYBINDINGDIVISORPROC VertexArrayBindingDivisor = nullptr;
+PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC DrawArraysInstancedBaseInstance = nullptr;
+PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC DrawElementsInstancedBaseInstance =
+    nullptr;
+
+static bool available = false;
+static bool binaries = false;
+
+static void loadProgramBinary(GLADloadproc loader) {
+    GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC)loader("glGetProgramBinary");
+    ProgramBinary = (PFNGLPROGRAMBINARYPROC)loader("glProgramBinary");
+    ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC)loader("glProgramParameteri");
+
+    GLint formats = 0;
+    if (GetProgramBinary && ProgramBinary && ProgramParameteri)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binaries = formats > 0;
+}
+
+bool load(GLADloadproc loader, bool allowed) {
+    available = false;
+    loadProgramBinary(loader);
+    if (!allowed) return false;
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major < 4 || (major == 4 && minor < 5)) return false;
+
+    CreateBuffers = (PFNGLCREATEBUFFERSPROC)loader("glCreateBuffers");
+    NamedBufferStorage = (PFNGLNAMEDBUFFERSTORAGEPROC)loader("glNamedBufferStorage");
+    NamedBufferSubData = (PFNGLNAMEDBUFFERSUBDATAPROC)loader("glNamedBufferSubData");
+    MapNamedBufferRange =
+        (PFNGLMAPNAMEDBUFFERRANGEPROC)loader("glMapNamedBufferRange");
+    UnmapNamedBuffer = (PFNGLUNMAPNAMEDBUFFERPROC)loader("glUnmapNamedBuffer");
+    CreateVertexArrays = (PFNGLCREATEVERTEXARRAYSPROC)loader("glCreateVertexArrays");
+    VertexArrayVertexBuffer =
+        (PFNGLVERTEXARRAYVERTEXBUFFERPROC)loader("glVertexArrayVertexBuffer");
+    VertexArrayElementBuffer =
+        (PFNGLVERTEXARRAYELEMENTBUFFERPROC)loader("glVertexArrayElementBuffer");
+    VertexArrayAttribFormat =
+        (PFNGLVERTEXARRAYATTRIBFORMATPROC)loader("glVertexArrayAttribFormat");
+    VertexArrayAttribBinding =
+        (PFNGLVERTEXARRAYATTRIBBINDINGPROC)loader("glVertexArrayAttribBinding");
+    EnableVertexArrayAttrib =
+        (PFNGLENABLEVERTEXARRAYATTRIBPROC)loader("glEnableVertexArrayAttrib");
+    VertexArrayBindingDivisor =
+        (PFNGLVERTEXARRAYBINDINGDIVISORPROC)loader("glVertexArrayBindingDivisor");
+    DrawArraysInstancedBaseInstance = (PFNGLDRAWARRAYSINSTANCEDBASEINSTANCEPROC)loader(
+        "glDrawArraysInstancedBaseInstance");
+    DrawElementsInstancedBaseInstance =
+        (PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC)loader(
+            "glDrawElementsInstancedBaseInstance");
+
+    available = CreateBuffers && NamedBufferStorage && NamedBufferSubData &&
+                MapNamedBufferRange && UnmapNamedBuffer && CreateVertexArrays &&
+                VertexArrayVertexBuffer && VertexArrayElementBuffer &&
+                VertexArrayAttribFormat && VertexArrayAttribBinding &&
+                EnableVertexArrayAttrib && VertexArrayBindingDivisor &&
+                DrawArraysInstancedBaseInstance &&
+                DrawElementsInstancedBaseInstance;
+    return available;
+}
+
+bool directStateAccess() { return available; }
+
+bool programBinary() { return binaries; }
+
+void vertexAttribute(GLuint vao, GLuint index, GLuint binding, GLint size,
+                     GLenum type, GLboolean normalized, GLuint offset) {
+    VertexArrayAttribFormat(vao, index, size, type, normalized, offset);
+    VertexArrayAttribBinding(vao, index, binding);
+    EnableVertexArrayAttrib(vao, index);
+}
+
+}  // namespace GLExt
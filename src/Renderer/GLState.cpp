@@ -0,0 +1,85 @@
+#include "Renderer/GLState.h"
+
+const GLenum GLState::CAPABILITIES[GLState::CAPABILITY_COUNT] = {
+    GL_DEPTH_TEST, GL_BLEND, GL_PROGRAM_POINT_SIZE, GL_CULL_FACE};
+
+void GLState::useProgram(GLuint program) {
+    if (!change(this->program != program)) return;
+    this->program = program;
+    glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (!change(this->vao != vao)) return;
+    this->vao = vao;
+    glBindVertexArray(vao);
+}
+
+void GLState::setCapability(GLenum capability, bool enabled) {
+    for (int i = 0; i < CAPABILITY_COUNT; i++) {
+        if (CAPABILITIES[i] != capability) continue;
+
+        if (!change(capabilities[i] != (enabled ? 1 : 0))) return;
+        capabilities[i] = enabled ? 1 : 0;
+        break;
+    }
+    // Capabilities that are not shadowed are always issued
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    if (!change(blendSource != source || blendDestination != destination)) return;
+    blendSource = source;
+    blendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+void GLState::depthMask(bool write) {
+    if (!change(depthWrite != (write ? 1 : 0))) return;
+    depthWrite = write ? 1 : 0;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::polygonMode(GLenum mode) {
+    if (!change(polygon != mode)) return;
+    polygon = mode;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLState::lineWidth(GLfloat width) {
+    if (!change(line != width)) return;
+    line = width;
+    glLineWidth(width);
+}
+
+void GLState::pointSize(GLfloat size) {
+    if (!change(point != size)) return;
+    point = size;
+    glPointSize(size);
+}
+
+void GLState::apply(const RenderState& state) {
+    setCapability(GL_DEPTH_TEST, state.depthTest);
+    depthMask(state.depthWrite);
+    setCapability(GL_BLEND, state.blend != RenderState::BLEND_NONE);
+    if (state.blend == RenderState::BLEND_ALPHA)
+        blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    else if (state.blend == RenderState::BLEND_ADDITIVE)
+        blendFunc(GL_ONE, GL_ONE);
+    else if (state.blend == RenderState::BLEND_PREMULTIPLIED)
+        blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    setCapability(GL_PROGRAM_POINT_SIZE, state.programPointSize);
+    polygonMode(GL_FILL);
+}
+
+void GLState::invalidate() {
+    program = vao = -1;
+    for (int i = 0; i < CAPABILITY_COUNT; i++) capabilities[i] = -1;
+    blendSource = blendDestination = -1;
+    depthWrite = -1;
+    polygon = -1;
+    line = point = -1.0f;
+}
@@ -0,0 +1,103 @@
+#include "Renderer/HeadlessContext.h"
+
+#ifdef PLANET_SIM_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+#endif
+
+HeadlessContext::~HeadlessContext() { destroy(); }
+
+#ifdef PLANET_SIM_EGL
+
+static EGLDisplay surfacelessDisplay() {
+    // Prefer Mesa's surfaceless platform, which needs neither X nor a DRM device
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (extensions != nullptr && getPlatformDisplay != nullptr &&
+        std::strstr(extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                                EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY) return display;
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool HeadlessContext::create(bool allowGL45) {
+    EGLDisplay eglDisplay = surfacelessDisplay();
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+        return false;
+    display = eglDisplay;
+
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                       EGL_SURFACE_TYPE, 0, EGL_NONE};
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) ||
+        !eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) ||
+        configCount == 0) {
+        destroy();
+        return false;
+    }
+
+    const EGLint versions[][2] = {{4, 5}, {3, 3}};
+    for (const EGLint* version : versions) {
+        if (version[0] == 4 && !allowGL45) continue;
+
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, version[0],
+            EGL_CONTEXT_MINOR_VERSION, version[1],
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE};
+        context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT,
+                                   contextAttributes);
+        if (context != EGL_NO_CONTEXT) break;
+        context = nullptr;
+    }
+
+    if (context == nullptr ||
+        !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (display == nullptr) return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != nullptr) eglDestroyContext(display, context);
+    eglTerminate(display);
+    context = nullptr;
+    display = nullptr;
+    FBO = colorBuffer = 0;
+}
+
+void* HeadlessContext::loadProc(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+bool HeadlessContext::create(bool /*allowGL45*/) { return false; }
+
+void HeadlessContext::destroy() {}
+
+void* HeadlessContext::loadProc(const char* /*name*/) { return nullptr; }
+
+#endif  // PLANET_SIM_EGL
+
+void HeadlessContext::createFramebuffer(int width, int height) {
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                              colorBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
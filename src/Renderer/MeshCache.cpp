@@ -0,0 +1,40 @@
+#include "Renderer/MeshCache.h"
+
+#include <vector>
+
+const Mesh& MeshCache::icosphere(unsigned int subdivisions) {
+    auto found = icospheres.find(subdivisions);
+    if (found != icospheres.end()) return found->second;
+
+    Mesh mesh = upload(Geometry::genIcosphere(1.0f, subdivisions));
+    return icospheres.emplace(subdivisions, mesh).first->second;
+}
+
+Mesh MeshCache::upload(const Geometry::GeometryData& data) {
+    std::vector<GLfloat> interleaved;
+    interleaved.reserve(data.vertices.size() * 2);
+    for (size_t i = 0; i < data.vertices.size(); i += 3) {
+        interleaved.insert(interleaved.end(), &data.vertices[i], &data.vertices[i] + 3);
+        interleaved.insert(interleaved.end(), &data.normals[i], &data.normals[i] + 3);
+    }
+
+    Mesh mesh;
+    mesh.indexCount = static_cast<GLsizei>(data.indices.size());
+
+    glGenBuffers(1, &mesh.VBO);
+    glGenBuffers(1, &mesh.EBO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, interleaved.size() * sizeof(GLfloat),
+                 interleaved.data(), GL_STATIC_DRAW);
+
+    // Filled through the array target: the element binding belongs to whichever
+    // vertex array is bound, and there is none of our own here
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.EBO);
+    glBufferData(GL_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint),
+                 data.indices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return mesh;
+}
@@ -0,0 +1,315 @@
+#include "Renderer/PlanetSurfaces.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include <glm/glm.hpp>
+
+#include "utils/FileCache.h"
+#include "utils/Noise.h"
+#include "utils/ThreadPool.h"
+
+#ifdef PLANET_SIM_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+const uint32_t MAGIC = 0x46535350;  // "PSSF"
+// Bump whenever generate() changes, so old caches miss
+const uint32_t VERSION = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seed;
+    uint32_t resolution;
+    uint64_t rawSize;
+    uint64_t storedSize;
+    uint32_t compressed;
+    uint32_t padding;
+};
+
+// Direction through texel (s, t) of a face, in GL cube map order (+x, -x, +y,
+// -y, +z, -z) and orientation
+glm::vec3 faceDirection(int face, float s, float t) {
+    switch (face) {
+        case 0: return glm::vec3(1.0f, -t, -s);
+        case 1: return glm::vec3(-1.0f, -t, s);
+        case 2: return glm::vec3(s, 1.0f, t);
+        case 3: return glm::vec3(s, -1.0f, -t);
+        case 4: return glm::vec3(s, -t, 1.0f);
+        default: return glm::vec3(-s, -t, -1.0f);
+    }
+}
+
+struct Palette {
+    glm::vec3 deep, shallow, shore, low, high, rock, ice;
+};
+
+const Palette PALETTES[] = {
+    // Temperate
+    {{0.02f, 0.06f, 0.2f}, {0.05f, 0.2f, 0.4f}, {0.76f, 0.7f, 0.5f},
+     {0.2f, 0.45f, 0.15f}, {0.35f, 0.4f, 0.2f}, {0.45f, 0.4f, 0.35f},
+     {0.92f, 0.94f, 0.97f}},
+    // Arid
+    {{0.1f, 0.08f, 0.15f}, {0.25f, 0.3f, 0.35f}, {0.85f, 0.7f, 0.45f},
+     {0.75f, 0.5f, 0.3f}, {0.6f, 0.35f, 0.2f}, {0.45f, 0.3f, 0.25f},
+     {0.9f, 0.85f, 0.8f}},
+    // Frozen
+    {{0.05f, 0.1f, 0.2f}, {0.3f, 0.45f, 0.55f}, {0.7f, 0.75f, 0.8f},
+     {0.6f, 0.65f, 0.7f}, {0.5f, 0.55f, 0.6f}, {0.4f, 0.4f, 0.45f},
+     {0.97f, 0.98f, 1.0f}},
+};
+
+// glm::mix without extrapolation
+glm::vec3 blend(const glm::vec3& a, const glm::vec3& b, float t) {
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    return a + (b - a) * t;
+}
+
+uint8_t unorm(float value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+}  // namespace
+
+float PlanetSurfaces::add(uint32_t seed) {
+    seeds.push_back(seed);
+    return static_cast<float>((seeds.size() - 1) * FACES + 1);
+}
+
+std::string PlanetSurfaces::path(uint32_t seed) const {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%08x_%d.bin", seed, resolution);
+    return directory + "/" + name;
+}
+
+void PlanetSurfaces::generate(uint32_t seed, Surface& surface) const {
+    const int N = resolution;
+    PerlinNoise noise(seed);
+
+    // Everything but the terrain itself comes from the seed too
+    std::mt19937 random(seed ^ 0x9e3779b9u);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const Palette& palette = PALETTES[seed % 3];
+    float seaLevel = -0.15f + 0.25f * unit(random);
+    float frequency = 1.5f + 1.5f * unit(random);
+    glm::vec3 offset(100.0f * unit(random), 100.0f * unit(random),
+                     100.0f * unit(random));
+    const float relief = 0.02f;
+
+    // Pass 1: elevation above the sea, zero over water
+    std::vector<float> heights(FACES * N * N);
+    ThreadPool::get().parallelFor(FACES * N, [&](size_t job) {
+        int face = static_cast<int>(job) / N, row = static_cast<int>(job) % N;
+        float t = 2.0f * (row + 0.5f) / N - 1.0f;
+        for (int column = 0; column < N; column++) {
+            float s = 2.0f * (column + 0.5f) / N - 1.0f;
+            glm::vec3 direction = glm::normalize(faceDirection(face, s, t));
+            glm::vec3 p = direction * frequency + offset;
+            heights[(face * N + row) * N + column] = noise.fbm(p.x, p.y, p.z, 7);
+        }
+    });
+
+    surface.color.resize(FACES * N * N * 4);
+    surface.normal.resize(FACES * N * N * 4);
+
+    // Pass 2: colour from elevation and latitude, normals from neighbouring
+    // heights on the displaced sphere
+    ThreadPool::get().parallelFor(FACES * N, [&](size_t job) {
+        int face = static_cast<int>(job) / N, row = static_cast<int>(job) % N;
+        auto displaced = [&](int r, int c) {
+            r = std::min(std::max(r, 0), N - 1);
+            c = std::min(std::max(c, 0), N - 1);
+            glm::vec3 d = glm::normalize(faceDirection(
+                face, 2.0f * (c + 0.5f) / N - 1.0f, 2.0f * (r + 0.5f) / N - 1.0f));
+            float land = std::max(heights[(face * N + r) * N + c] - seaLevel, 0.0f);
+            return d * (1.0f + relief * land);
+        };
+
+        float t = 2.0f * (row + 0.5f) / N - 1.0f;
+        for (int column = 0; column < N; column++) {
+            size_t texel = (static_cast<size_t>(face * N + row) * N + column) * 4;
+            float s = 2.0f * (column + 0.5f) / N - 1.0f;
+            glm::vec3 direction = glm::normalize(faceDirection(face, s, t));
+            float elevation = heights[(face * N + row) * N + column] - seaLevel;
+            // Planets spin about their z axis, so the poles are at z = +-1
+            float latitude = std::fabs(direction.z);
+
+            glm::vec3 albedo;
+            float specular;
+            if (elevation < 0.0f) {
+                albedo = blend(palette.shallow, palette.deep, -elevation * 4.0f);
+                specular = 1.0f;
+            } else {
+                albedo = elevation < 0.02f ? palette.shore
+                                           : blend(palette.low, palette.high,
+                                                 elevation * 3.0f);
+                albedo = blend(albedo, palette.rock, (elevation - 0.25f) * 5.0f);
+                specular = 0.1f;
+            }
+            // Ice caps reach further down on high ground
+            float ice = (latitude + 0.5f * std::max(elevation, 0.0f) - 0.8f) * 10.0f;
+            albedo = blend(albedo, palette.ice, ice);
+
+            surface.color[texel + 0] = unorm(albedo.x);
+            surface.color[texel + 1] = unorm(albedo.y);
+            surface.color[texel + 2] = unorm(albedo.z);
+            surface.color[texel + 3] = unorm(specular);
+
+            glm::vec3 ds = displaced(row, column + 1) - displaced(row, column - 1);
+            glm::vec3 dt = displaced(row + 1, column) - displaced(row - 1, column);
+            glm::vec3 normal = glm::normalize(glm::cross(ds, dt));
+            if (glm::dot(normal, direction) < 0.0f) normal = -normal;
+
+            surface.normal[texel + 0] = unorm(normal.x * 0.5f + 0.5f);
+            surface.normal[texel + 1] = unorm(normal.y * 0.5f + 0.5f);
+            surface.normal[texel + 2] = unorm(normal.z * 0.5f + 0.5f);
+            surface.normal[texel + 3] = 255;
+        }
+    });
+}
+
+bool PlanetSurfaces::readCache(uint32_t seed, Surface& surface) const {
+    std::string name = path(seed);
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(name, error);
+    if (error || fileSize < sizeof(Header)) return false;
+
+    std::ifstream file(name, std::ios::binary);
+    Header header;
+    size_t faceBytes = static_cast<size_t>(FACES) * resolution * resolution * 4;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != MAGIC || header.version != VERSION || header.seed != seed ||
+        header.resolution != static_cast<uint32_t>(resolution) ||
+        header.rawSize != 2 * faceBytes)
+        return false;
+
+    // Sizes come from disk: a truncated or corrupt entry must miss before it
+    // sizes any allocation. Stored data fills the rest of the file, and is never
+    // larger than raw data is allowed to deflate to.
+    uint64_t storedLimit = header.rawSize;
+#ifdef PLANET_SIM_ZLIB
+    if (header.compressed)
+        storedLimit = compressBound(static_cast<uLong>(header.rawSize));
+#endif
+    if (header.storedSize != fileSize - sizeof(Header) ||
+        header.storedSize > storedLimit)
+        return false;
+
+    std::vector<uint8_t> stored(header.storedSize);
+    if (!file.read(reinterpret_cast<char*>(stored.data()), stored.size())) return false;
+
+    std::vector<uint8_t> raw;
+    if (header.compressed) {
+#ifdef PLANET_SIM_ZLIB
+        raw.resize(header.rawSize);
+        uLongf length = static_cast<uLongf>(raw.size());
+        if (uncompress(raw.data(), &length, stored.data(), stored.size()) != Z_OK ||
+            length != raw.size())
+            return false;
+#else
+        return false;
+#endif
+    } else {
+        if (stored.size() != header.rawSize) return false;
+        raw.swap(stored);
+    }
+
+    surface.color.assign(raw.begin(), raw.begin() + faceBytes);
+    surface.normal.assign(raw.begin() + faceBytes, raw.end());
+    return true;
+}
+
+void PlanetSurfaces::writeCache(uint32_t seed, const Surface& surface) const {
+    std::vector<uint8_t> raw(surface.color);
+    raw.insert(raw.end(), surface.normal.begin(), surface.normal.end());
+
+    Header header = {MAGIC, VERSION, seed, static_cast<uint32_t>(resolution),
+                     raw.size(), raw.size(), 0, 0};
+    const std::vector<uint8_t>* stored = &raw;
+#ifdef PLANET_SIM_ZLIB
+    std::vector<uint8_t> compressed(compressBound(raw.size()));
+    uLongf length = static_cast<uLongf>(compressed.size());
+    if (compress2(compressed.data(), &length, raw.data(), raw.size(),
+                  Z_DEFAULT_COMPRESSION) == Z_OK) {
+        compressed.resize(length);
+        header.storedSize = length;
+        header.compressed = 1;
+        stored = &compressed;
+    }
+#endif
+
+    FileCache::write(path(seed),
+                     {{&header, sizeof(header)}, {stored->data(), stored->size()}});
+}
+
+void PlanetSurfaces::build() {
+    auto start = std::chrono::steady_clock::now();
+    cached = 0;
+    if (seeds.empty()) return;
+
+    GLsizei layers = static_cast<GLsizei>(seeds.size() * FACES);
+    if (colorArray == 0) {
+        glGenTextures(1, &colorArray);
+        glGenTextures(1, &normalArray);
+    }
+    for (GLuint array : {colorArray, normalArray}) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, resolution, resolution, layers,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    Surface surface;
+    for (size_t i = 0; i < seeds.size(); i++) {
+        if (readCache(seeds[i], surface)) {
+            cached++;
+        } else {
+            generate(seeds[i], surface);
+            writeCache(seeds[i], surface);
+        }
+
+        GLint layer = static_cast<GLint>(i * FACES);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, colorArray);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, resolution, resolution,
+                        FACES, GL_RGBA, GL_UNSIGNED_BYTE, surface.color.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, normalArray);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, resolution, resolution,
+                        FACES, GL_RGBA, GL_UNSIGNED_BYTE, surface.normal.data());
+    }
+
+    for (GLuint array : {colorArray, normalArray}) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    buildMilliseconds = elapsed.count();
+}
+
+void PlanetSurfaces::bind() const {
+    glActiveTexture(GL_TEXTURE0 + COLOR_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, colorArray);
+    glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalArray);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void PlanetSurfaces::attach(const Shader& shader) {
+    shader.use();
+    shader.setInt("surfaceColors", COLOR_UNIT);
+    shader.setInt("surfaceNormals", NORMAL_UNIT);
+}
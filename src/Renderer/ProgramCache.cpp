@@ -0,0 +1,109 @@
+#include "Renderer/ProgramCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Renderer/GLExt.h"
+#include "utils/FileCache.h"
+
+namespace {
+
+const uint32_t MAGIC = 0x42505350;  // "PSPB"
+const uint32_t VERSION = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+    float buildTime;
+    uint32_t padding;
+};
+
+uint64_t hashString(const char* text, uint64_t hash) {
+    if (text == nullptr) return hash;
+    // Include the terminator, so "ab" + "c" and "a" + "bc" differ
+    return FileCache::hash(text, std::char_traits<char>::length(text) + 1, hash);
+}
+
+}  // namespace
+
+uint64_t ProgramCache::key(const std::string& vertex,
+                           const std::string& fragment) const {
+    uint64_t hash = hashString(vertex.c_str(), FileCache::HASH_SEED);
+    hash = hashString(fragment.c_str(), hash);
+    hash = hashString((const char*)glGetString(GL_VENDOR), hash);
+    hash = hashString((const char*)glGetString(GL_RENDERER), hash);
+    hash = hashString((const char*)glGetString(GL_VERSION), hash);
+    return hash;
+}
+
+std::string ProgramCache::path(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return directory + "/" + name;
+}
+
+bool ProgramCache::load(GLuint program, uint64_t key) {
+    if (!GLExt::programBinary()) {
+        misses++;
+        return false;
+    }
+
+    std::string name = path(key);
+    std::error_code error;
+    uintmax_t fileSize = std::filesystem::file_size(name, error);
+    if (error || fileSize < sizeof(Header)) {
+        misses++;
+        return false;
+    }
+
+    // The length comes from disk, so a corrupt entry must miss before it sizes
+    // the allocation
+    std::ifstream file(name, std::ios::binary);
+    Header header;
+    std::vector<char> binary;
+    bool read = false;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        header.magic == MAGIC && header.version == VERSION && header.key == key &&
+        header.length > 0 && header.length <= fileSize - sizeof(Header)) {
+        binary.resize(header.length);
+        read = static_cast<bool>(file.read(binary.data(), header.length));
+    }
+
+    GLint linked = GL_FALSE;
+    if (read) {
+        GLExt::ProgramBinary(program, header.format, binary.data(),
+                             static_cast<GLsizei>(binary.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    if (linked != GL_TRUE) {
+        misses++;
+        return false;
+    }
+    hits++;
+    saved += header.buildTime;
+    return true;
+}
+
+void ProgramCache::store(GLuint program, uint64_t key, float buildTime) {
+    if (!GLExt::programBinary()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLExt::GetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    Header header = {MAGIC, VERSION, key, format, (uint32_t)written, buildTime, 0};
+    FileCache::write(path(key),
+                     {{&header, sizeof(header)}, {binary.data(), (size_t)written}});
+}
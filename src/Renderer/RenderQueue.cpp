@@ -0,0 +1,47 @@
+#include "Renderer/RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Positive floats order like their bit patterns; keep the top 24 bits
+static uint64_t depthBits(float depth) {
+    if (!(depth > 0.0f)) return 0;
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> 8;
+}
+
+void RenderQueue::submit(const Shader& shader, GLuint vao, const RenderState& state,
+                         float depth, std::function<void()> draw) {
+    uint64_t layer = state.blend;
+    uint64_t program = shader.ID & 0xFFF;
+    uint64_t array = vao & 0xFFFF;
+    uint64_t stateKey = state.key() & 0xFF;
+    uint64_t depthKey = depthBits(depth);
+
+    uint64_t key = layer << 62;
+    if (state.blend == RenderState::BLEND_NONE) {
+        key |= program << 48 | array << 32 | stateKey << 24 | depthKey;
+    } else {
+        // Back to front: larger depths first
+        key |= (0xFFFFFF - depthKey) << 36 | program << 24 | array << 8 | stateKey;
+    }
+
+    items.push_back(Item{key, &shader, state, std::move(draw)});
+}
+
+void RenderQueue::flush() {
+    // Stable, so equal keys keep submission order
+    std::stable_sort(items.begin(), items.end(),
+                     [](const Item& a, const Item& b) { return a.key < b.key; });
+
+    GLState& state = GLState::get();
+    for (const Item& item : items) {
+        item.shader->use();
+        state.apply(item.state);
+        item.draw();
+    }
+
+    lastItemCount = items.size();
+    items.clear();
+}
@@ -0,0 +1,169 @@
+#include "Renderer/SphereBVH.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/ThreadPool.h"
+
+// Leaves fitted per job during a refit
+static const size_t LEAF_CHUNK = 256;
+
+// Smallest sphere enclosing two spheres
+static void mergeSpheres(const glm::vec3& ca, float ra, const glm::vec3& cb, float rb,
+                         glm::vec3& center, float& radius) {
+    float d = glm::length(cb - ca);
+    if (d + rb <= ra) {
+        center = ca, radius = ra;
+    } else if (d + ra <= rb) {
+        center = cb, radius = rb;
+    } else {
+        radius = (d + ra + rb) * 0.5f;
+        center = ca + (cb - ca) * ((radius - ra) / d);
+    }
+}
+
+void SphereBVH::build(const glm::vec3* centers, const float* radii, size_t count,
+                      unsigned int leafSize) {
+    this->leafSize = std::max(leafSize, 1u);
+
+    nodes.clear();
+    leaves.clear();
+    primitiveOrder.resize(count);
+    for (size_t i = 0; i < count; i++) primitiveOrder[i] = static_cast<uint32_t>(i);
+
+    if (count == 0) {
+        leafRadiusSum = builtLeafRadiusSum = 0.0f;
+        return;
+    }
+
+    nodes.reserve(2 * (count / this->leafSize + 1));
+    buildNode(centers, 0, static_cast<uint32_t>(count));
+
+    refit(centers, radii);
+    builtLeafRadiusSum = leafRadiusSum;
+}
+
+uint32_t SphereBVH::buildNode(const glm::vec3* centers, uint32_t first,
+                              uint32_t count) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(Node{glm::vec3(0.0f), 0.0f, first, count, 0});
+
+    if (count <= leafSize) {
+        leaves.push_back(index);
+        return index;
+    }
+
+    // Split at the median along the widest axis of the centres
+    glm::vec3 lo(INFINITY), hi(-INFINITY);
+    for (uint32_t i = first; i < first + count; i++) {
+        lo = glm::min(lo, centers[primitiveOrder[i]]);
+        hi = glm::max(hi, centers[primitiveOrder[i]]);
+    }
+    glm::vec3 extent = hi - lo;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2)
+                                   : (extent.y > extent.z ? 1 : 2);
+
+    uint32_t half = count / 2;
+    auto begin = primitiveOrder.begin() + first;
+    std::nth_element(begin, begin + half, begin + count,
+                     [&](uint32_t a, uint32_t b) {
+                         return centers[a][axis] < centers[b][axis];
+                     });
+
+    buildNode(centers, first, half);
+    uint32_t right = buildNode(centers, first + half, count - half);
+    nodes[index].right = right;
+    return index;
+}
+
+void SphereBVH::fitLeaf(Node& node, const glm::vec3* centers,
+                        const float* radii) const {
+    glm::vec3 lo(INFINITY), hi(-INFINITY);
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        uint32_t p = primitiveOrder[i];
+        lo = glm::min(lo, centers[p] - radii[p]);
+        hi = glm::max(hi, centers[p] + radii[p]);
+    }
+
+    node.center = (lo + hi) * 0.5f;
+    node.radius = 0.0f;
+    for (uint32_t i = node.first; i < node.first + node.count; i++) {
+        uint32_t p = primitiveOrder[i];
+        node.radius =
+            std::max(node.radius, glm::length(centers[p] - node.center) + radii[p]);
+    }
+}
+
+void SphereBVH::refit(const glm::vec3* centers, const float* radii) {
+    if (nodes.empty()) return;
+
+    // Leaves are independent, so they are fitted in parallel
+    size_t chunks = (leaves.size() + LEAF_CHUNK - 1) / LEAF_CHUNK;
+    std::vector<float> chunkRadii(chunks, 0.0f);
+    ThreadPool::get().parallelFor(chunks, [&](size_t chunk) {
+        size_t end = std::min(leaves.size(), (chunk + 1) * LEAF_CHUNK);
+        for (size_t i = chunk * LEAF_CHUNK; i < end; i++) {
+            Node& leaf = nodes[leaves[i]];
+            fitLeaf(leaf, centers, radii);
+            chunkRadii[chunk] += leaf.radius;
+        }
+    });
+
+    leafRadiusSum = 0.0f;
+    for (float r : chunkRadii) leafRadiusSum += r;
+
+    // Children always follow their parent, so a reverse sweep is bottom-up
+    for (size_t i = nodes.size(); i-- > 0;) {
+        Node& node = nodes[i];
+        if (node.right == 0) continue;
+
+        const Node& left = nodes[i + 1];
+        const Node& right = nodes[node.right];
+        mergeSpheres(left.center, left.radius, right.center, right.radius, node.center,
+                     node.radius);
+    }
+}
+
+size_t SphereBVH::cull(const Frustum& frustum, std::vector<Range>& ranges) const {
+    if (nodes.empty()) return 0;
+
+    size_t visible = 0;
+    auto emit = [&](uint32_t first, uint32_t count) {
+        if (!ranges.empty() && ranges.back().first + ranges.back().second == first)
+            ranges.back().second += count;
+        else
+            ranges.emplace_back(first, count);
+        visible += count;
+    };
+
+    uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+
+        Frustum::Containment containment = frustum.classify(node.center, node.radius);
+        if (containment == Frustum::OUTSIDE) continue;
+
+        // Leaves are small enough that their primitives are not tested one by one
+        if (containment == Frustum::INSIDE || node.right == 0) {
+            emit(node.first, node.count);
+            continue;
+        }
+
+        // Left is pushed last so ranges come out in order and merge
+        stack[top++] = node.right;
+        stack[top++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+    }
+    return visible;
+}
+
+size_t SphereBVH::cull(const Frustum& frustum, std::vector<uint32_t>& indices) const {
+    std::vector<Range> ranges;
+    size_t visible = cull(frustum, ranges);
+
+    for (const Range& range : ranges)
+        indices.insert(indices.end(), primitiveOrder.begin() + range.first,
+                       primitiveOrder.begin() + range.first + range.second);
+    return visible;
+}
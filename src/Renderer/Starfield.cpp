@@ -0,0 +1,231 @@
+#include "Renderer/Starfield.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "Renderer/GLState.h"
+#include "utils/FileCache.h"
+
+static_assert(sizeof(CatalogStar) == 20, "CatalogStar is stored packed");
+
+namespace {
+
+const uint32_t MAGIC = 0x53545350;  // "PSTS"
+const uint32_t VERSION = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    // Size and modification time of the catalog the cache was built from
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint32_t count;
+    uint32_t tierFirst[Starfield::TIER_COUNT + 1];
+};
+
+int tierOf(float magnitude) {
+    int tier = static_cast<int>(std::floor(magnitude)) - Starfield::FIRST_MAGNITUDE;
+    return std::min(std::max(tier, 0), Starfield::TIER_COUNT - 1);
+}
+
+// Colour of a star from its B-V index, through the Ballesteros temperature and
+// a fit of the blackbody colour at that temperature
+uint32_t colorIndexToRGBA(float bv) {
+    bv = std::min(std::max(bv, -0.4f), 2.0f);
+    float t = 46.0f * (1.0f / (0.92f * bv + 1.7f) + 1.0f / (0.92f * bv + 0.62f));
+
+    float r = t <= 66.0f ? 255.0f : 329.7f * std::pow(t - 60.0f, -0.1332f);
+    float g = t <= 66.0f ? 99.47f * std::log(t) - 161.12f
+                         : 288.12f * std::pow(t - 60.0f, -0.0755f);
+    float b = t >= 66.0f   ? 255.0f
+              : t <= 19.0f ? 0.0f
+                           : 138.52f * std::log(t - 10.0f) - 305.04f;
+
+    auto channel = [](float c) {
+        return static_cast<uint32_t>(std::min(std::max(c, 0.0f), 255.0f));
+    };
+    return channel(r) | channel(g) << 8 | channel(b) << 16 | 255u << 24;
+}
+
+// Skips separators; false at the end of the line
+bool nextField(const char*& p) {
+    while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r') p++;
+    return *p != '\0' && *p != '\n' && *p != '#';
+}
+
+bool parseCatalog(const std::string& path, std::vector<CatalogStar>& stars) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::string text((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+
+    const float toRadians = 3.14159265f / 180.0f;
+    const char* p = text.c_str();
+    while (*p != '\0') {
+        float values[4];
+        int fields = 0;
+        while (fields < 4 && nextField(p)) {
+            char* end;
+            values[fields] = std::strtof(p, &end);
+            if (end == p) break;
+            p = end;
+            fields++;
+        }
+
+        if (fields >= 3) {
+            float ra = values[0] * toRadians, dec = values[1] * toRadians;
+            // North celestial pole up the y axis, like the orbital plane's normal
+            uint32_t color = fields == 4 ? colorIndexToRGBA(values[3]) : 0xFFFFFFFFu;
+            CatalogStar star = {{std::cos(dec) * std::cos(ra), std::sin(dec),
+                                 -std::cos(dec) * std::sin(ra)},
+                                values[2],
+                                color};
+            stars.push_back(star);
+        }
+
+        // Whatever is left of the line: comments, names, malformed fields
+        while (*p != '\0' && *p != '\n') p++;
+        if (*p == '\n') p++;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool Starfield::load(const std::string& catalogPath) {
+    auto start = std::chrono::steady_clock::now();
+    starCount = 0;
+    cacheHit = false;
+
+    std::error_code error;
+    uint64_t sourceSize = std::filesystem::file_size(catalogPath, error);
+    bool haveSource = !error;
+    int64_t sourceTime = 0;
+    if (haveSource) {
+        auto modified = std::filesystem::last_write_time(catalogPath, error);
+        sourceTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    }
+
+    // A cache without its catalog is still good: it may have been shipped alone.
+    // The count comes from disk, so it must fit in the file before it sizes the
+    // vertex buffer, and the tiers must be ordered before they size draws.
+    uintmax_t cacheSize = std::filesystem::file_size(cachePath, error);
+    if (error) cacheSize = 0;
+    std::ifstream cache(cachePath, std::ios::binary);
+    Header header;
+    if (cacheSize >= sizeof(Header) &&
+        cache.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        header.magic == MAGIC && header.version == VERSION && header.count > 0 &&
+        header.count <= (cacheSize - sizeof(Header)) / sizeof(CatalogStar) &&
+        std::is_sorted(header.tierFirst, header.tierFirst + TIER_COUNT + 1) &&
+        header.tierFirst[TIER_COUNT] == header.count &&
+        (!haveSource ||
+         (header.sourceSize == sourceSize && header.sourceTime == sourceTime))) {
+        // Read the records straight into the vertex buffer
+        upload(nullptr, header.count);
+        GLsizeiptr bytes = header.count * sizeof(CatalogStar);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        void* mapped =
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        bool read = false;
+        if (mapped != nullptr) {
+            read = static_cast<bool>(cache.read(static_cast<char*>(mapped), bytes));
+            // The contents can be lost while mapped
+            if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) read = false;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        if (read) {
+            std::copy(header.tierFirst, header.tierFirst + TIER_COUNT + 1, tierFirst);
+            starCount = header.count;
+            cacheHit = true;
+        }
+    }
+    cache.close();
+
+    if (!cacheHit) {
+        std::vector<CatalogStar> stars;
+        if (!haveSource || !parseCatalog(catalogPath, stars) || stars.empty())
+            return false;
+
+        std::stable_sort(stars.begin(), stars.end(),
+                         [](const CatalogStar& a, const CatalogStar& b) {
+                             return a.magnitude < b.magnitude;
+                         });
+        uint32_t next = 0;
+        for (int tier = 0; tier < TIER_COUNT; tier++) {
+            tierFirst[tier] = next;
+            while (next < stars.size() && tierOf(stars[next].magnitude) == tier) next++;
+        }
+        tierFirst[TIER_COUNT] = static_cast<uint32_t>(stars.size());
+
+        upload(stars.data(), stars.size());
+        starCount = stars.size();
+
+        Header out = {MAGIC, VERSION, sourceSize, sourceTime,
+                      static_cast<uint32_t>(stars.size()), {}};
+        std::copy(tierFirst, tierFirst + TIER_COUNT + 1, out.tierFirst);
+        size_t bytes = stars.size() * sizeof(CatalogStar);
+        FileCache::write(cachePath, {{&out, sizeof(out)}, {stars.data(), bytes}});
+    }
+
+    std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    loadMilliseconds = elapsed.count();
+    return true;
+}
+
+void Starfield::upload(const CatalogStar* stars, size_t count) {
+    if (VAO == 0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        GLState::get().bindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(CatalogStar), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CatalogStar),
+                              (void*)offsetof(CatalogStar, color));
+        glEnableVertexAttribArray(1);
+        GLState::get().bindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(CatalogStar), stars, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+float Starfield::limitingMagnitude() const {
+    // Each factor of 10^0.4 in light is one magnitude fainter at the threshold
+    return REFERENCE_MAGNITUDE + 2.5f * std::log10(std::max(exposure, 1.0e-6f));
+}
+
+void Starfield::render(const Shader& shader, float maxPointSize) {
+    drawCalls = 0;
+    drawnStars = 0;
+    if (starCount == 0) return;
+
+    float limit = limitingMagnitude();
+    shader.use();
+    shader.setFloat("limitingMagnitude", limit);
+    shader.setFloat("maxPointSize", maxPointSize);
+    GLState::get().bindVertexArray(VAO);
+
+    // The last tier drawn straddles the limit; starfield.vs drops its faint end
+    int lastTier = tierOf(limit);
+    for (int tier = 0; tier <= lastTier; tier++) {
+        GLsizei count = static_cast<GLsizei>(tierFirst[tier + 1] - tierFirst[tier]);
+        if (count == 0) continue;
+        glDrawArrays(GL_POINTS, static_cast<GLint>(tierFirst[tier]), count);
+        drawCalls++;
+        drawnStars += count;
+    }
+}
@@ -0,0 +1,119 @@
+#include "Renderer/StreamBuffer.h"
+
+#include <cstring>
+#include <utility>
+
+#include "Renderer/GLExt.h"
+
+StreamBuffer::StreamBuffer(GLenum target, GLsizeiptr stride)
+    : target(target), stride(stride) {}
+
+StreamBuffer::~StreamBuffer() { release(); }
+
+StreamBuffer::StreamBuffer(StreamBuffer&& other) noexcept
+    : target(other.target), stride(other.stride) {
+    *this = std::move(other);
+}
+
+StreamBuffer& StreamBuffer::operator=(StreamBuffer&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+
+    target = other.target;
+    stride = other.stride;
+    id = std::exchange(other.id, 0);
+    bufferGeneration = other.bufferGeneration;
+    regionSize = std::exchange(other.regionSize, 0);
+    region = std::exchange(other.region, 0);
+    regionOffset = std::exchange(other.regionOffset, 0);
+    persistent = std::exchange(other.persistent, nullptr);
+    for (int i = 0; i < REGIONS; i++)
+        fences[i] = std::exchange(other.fences[i], nullptr);
+    return *this;
+}
+
+void StreamBuffer::release() {
+    for (GLsync& fence : fences) {
+        if (fence != nullptr) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (persistent != nullptr) GLExt::UnmapNamedBuffer(id);
+    persistent = nullptr;
+    if (id != 0) glDeleteBuffers(1, &id);
+    id = 0;
+    regionSize = 0;
+    region = 0;
+    regionOffset = 0;
+}
+
+void* StreamBuffer::map(GLsizeiptr bytes) {
+    if (bytes <= 0) bytes = stride;
+
+    if (!GLExt::directStateAccess()) {
+        if (id == 0) {
+            glGenBuffers(1, &id);
+            bufferGeneration++;
+        }
+        glBindBuffer(target, id);
+        if (bytes > regionSize) regionSize = bytes + bytes / 2;
+        glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+        return glMapBufferRange(target, 0, bytes,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if (id == 0 || bytes > regionSize) allocate(bytes);
+    if (persistent == nullptr) return nullptr;
+
+    // Everything that reads the current region has been issued by now
+    if (fences[region] != nullptr) glDeleteSync(fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    region = (region + 1) % REGIONS;
+    regionOffset = region * regionSize;
+    wait(region);
+    return persistent + regionOffset;
+}
+
+bool StreamBuffer::unmap() {
+    // Persistent mappings are coherent and stay mapped
+    if (GLExt::directStateAccess()) return true;
+
+    glBindBuffer(target, id);
+    return glUnmapBuffer(target) == GL_TRUE;
+}
+
+bool StreamBuffer::write(const void* data, GLsizeiptr bytes) {
+    void* mapped = map(bytes);
+    if (mapped == nullptr) return false;
+
+    std::memcpy(mapped, data, bytes);
+    return unmap();
+}
+
+void StreamBuffer::allocate(GLsizeiptr bytes) {
+    // The old buffer is released by the driver once pending draws are done
+    release();
+
+    // Regions start on a whole stride, so offsets convert to first elements
+    regionSize = bytes + bytes / 2;
+    regionSize = (regionSize + stride - 1) / stride * stride;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLExt::CreateBuffers(1, &id);
+    GLExt::NamedBufferStorage(id, regionSize * REGIONS, nullptr, flags);
+    persistent = static_cast<char*>(
+        GLExt::MapNamedBufferRange(id, 0, regionSize * REGIONS, flags));
+    region = 0;
+    bufferGeneration++;
+}
+
+void StreamBuffer::wait(int index) {
+    GLsync fence = fences[index];
+    if (fence == nullptr) return;
+
+    // Flush once so the fence is guaranteed to signal, then block until it does
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+    glDeleteSync(fence);
+    fences[index] = nullptr;
+}
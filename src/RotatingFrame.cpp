@@ -0,0 +1,170 @@
+#include "RotatingFrame.h"
+#include "Physics/Gravity.h"
+#include "Renderer/GLState.h"
+
+#include <algorithm>
+#include <cmath>
+
+static bool changed(float value, float reference, float tolerance) {
+    return fabsf(value - reference) > tolerance * std::max(fabsf(reference), 1.0e-12f);
+}
+
+RotatingFrame::RotatingFrame() { initVertexData(); }
+
+bool RotatingFrame::update(const std::vector<Body*>& bodies) {
+    isValid = false;
+    int count = static_cast<int>(bodies.size());
+    if (primary < 0 || secondary < 0 || primary >= count || secondary >= count ||
+        primary == secondary)
+        return false;
+
+    // The L-point guesses assume the secondary is the lighter body
+    const Body* body1 = bodies[primary];
+    const Body* body2 = bodies[secondary];
+    if (body2->mass > body1->mass) std::swap(body1, body2);
+
+    float totalMass = body1->mass + body2->mass;
+    if (totalMass <= 0.0f) return false;
+
+    glm::vec3 r = body2->position - body1->position;
+    glm::vec3 v = body2->velocity - body1->velocity;
+    separation = glm::length(r);
+    if (separation == 0.0f) return false;
+
+    // Osculating elements of the relative orbit
+    float gm = Gravity::G * totalMass;
+    glm::vec3 h = glm::cross(r, v);
+    float energy = 0.5f * glm::dot(v, v) - gm / separation;
+
+    Elements elements;
+    elements.massRatio = body2->mass / totalMass;
+    elements.semiMajorAxis = energy < 0.0f ? -gm / (2.0f * energy) : separation;
+    elements.eccentricity = glm::length(glm::cross(v, h) / gm - r / separation);
+
+    if (changed(elements.massRatio, solved.massRatio, elementTolerance) ||
+        changed(elements.semiMajorAxis, solved.semiMajorAxis, elementTolerance) ||
+        changed(elements.eccentricity, solved.eccentricity, elementTolerance)) {
+        solveLagrangePoints(elements.massRatio);
+        solved = elements;
+    }
+
+    // Frame axes: secondary on +x, orbit normal as the rotation axis
+    float hLength = glm::length(h);
+    normal = hLength > 0.0f ? h / hLength : glm::vec3(0.0f, 1.0f, 0.0f);
+    axisX = r / separation;
+    axisY = glm::normalize(glm::cross(normal, axisX));
+
+    barycenter = (body1->position * body1->mass + body2->position * body2->mass) /
+                 totalMass;
+    meanMotion2 = gm / powf(elements.semiMajorAxis, 3.0f);
+    gm1 = Gravity::G * body1->mass;
+    gm2 = Gravity::G * body2->mass;
+    position1 = body1->position;
+    position2 = body2->position;
+
+    for (int i = 0; i < 5; i++)
+        lagrangePoints[i] =
+            barycenter + separation * (unitX[i] * axisX + unitY[i] * axisY);
+
+    float turned = acosf(glm::clamp(glm::dot(axisX, revisedAxisX), -1.0f, 1.0f));
+    if (frameRevision == 0 || turned > motionTolerance ||
+        glm::length(barycenter - revisedBarycenter) > motionTolerance * separation ||
+        changed(separation, revisedSeparation, motionTolerance)) {
+        revisedBarycenter = barycenter;
+        revisedAxisX = axisX;
+        revisedSeparation = separation;
+        frameRevision++;
+    }
+
+    isValid = true;
+    return true;
+}
+
+float RotatingFrame::effectiveDepth(const glm::vec3& position) const {
+    float r1 = glm::length(position - position1);
+    float r2 = glm::length(position - position2);
+
+    glm::vec3 offset = position - barycenter;
+    float axial = glm::dot(offset, normal);
+    float rho2 = glm::dot(offset, offset) - axial * axial;
+
+    float depth = 0.5f * meanMotion2 * rho2;
+    if (r1 > 0.0f) depth += gm1 / r1;
+    if (r2 > 0.0f) depth += gm2 / r2;
+    return depth;
+}
+
+void RotatingFrame::solveLagrangePoints(float massRatio) {
+    // Newton iteration on the gradient of the dimensionless effective potential
+    // Omega = (x^2 + y^2) / 2 + (1 - mu) / r1 + mu / r2, all five points at once.
+    // The lane loops are branch free so they vectorise. Doubles keep L4/L5
+    // converging for the tiny mass ratios of planet/moon pairs.
+    const double mu = massRatio;
+    const double hill = cbrt(mu / 3.0);
+    double x[5] = {1.0 - mu - hill, 1.0 - mu + hill, -1.0 - 5.0 * mu / 12.0, 0.5 - mu,
+                   0.5 - mu};
+    double y[5] = {0.0, 0.0, 0.0, 0.8660254037844386, -0.8660254037844386};
+
+    for (int iteration = 0; iteration < 32; iteration++) {
+        double largestStep = 0.0;
+
+        for (int i = 0; i < 5; i++) {
+            double dx1 = x[i] + mu, dx2 = x[i] - 1.0 + mu;
+            double r1sq = dx1 * dx1 + y[i] * y[i];
+            double r2sq = dx2 * dx2 + y[i] * y[i];
+            double r1 = sqrt(r1sq), r2 = sqrt(r2sq);
+            double a = (1.0 - mu) / (r1sq * r1), b = mu / (r2sq * r2);
+            double a5 = 3.0 * a / r1sq, b5 = 3.0 * b / r2sq;
+
+            double gx = x[i] - a * dx1 - b * dx2;
+            double gy = y[i] - a * y[i] - b * y[i];
+            double hxx = 1.0 - a - b + a5 * dx1 * dx1 + b5 * dx2 * dx2;
+            double hyy = 1.0 - a - b + (a5 + b5) * y[i] * y[i];
+            double hxy = (a5 * dx1 + b5 * dx2) * y[i];
+
+            double det = hxx * hyy - hxy * hxy;
+            double inv = det != 0.0 ? 1.0 / det : 0.0;
+            double stepX = (hyy * gx - hxy * gy) * inv;
+            double stepY = (hxx * gy - hxy * gx) * inv;
+
+            x[i] -= stepX;
+            y[i] -= stepY;
+            largestStep = std::max(largestStep, fabs(stepX) + fabs(stepY));
+        }
+
+        if (largestStep < 1.0e-12) break;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        unitX[i] = static_cast<float>(x[i]);
+        unitY[i] = static_cast<float>(y[i]);
+    }
+    solves++;
+}
+
+void RotatingFrame::renderLagrangePoints(const Shader& shader) {
+    if (!isValid) return;
+
+    if (!this->stream.write(lagrangePoints, sizeof(lagrangePoints))) return;
+
+    GLState::get().bindVertexArray(this->VAO);
+    if (this->stream.generation() != this->streamGeneration) {
+        glBindBuffer(GL_ARRAY_BUFFER, this->stream.buffer());
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat),
+                              (void*)0);
+        glEnableVertexAttribArray(0);
+        this->streamGeneration = this->stream.generation();
+    }
+
+    glm::mat4 model(1.0f);
+    shader.setMat4("model", model);
+    shader.setVec3("color", glm::vec3(0.2f, 1.0f, 0.4f));
+
+    GLState::get().pointSize(6.0f);
+    glDrawArrays(GL_POINTS, this->stream.first(), 5);
+}
+
+void RotatingFrame::initVertexData() {
+    // The vertex attribute is pointed at the stream on the first draw
+    glGenVertexArrays(1, &this->VAO);
+}
@@ -0,0 +1,170 @@
+#include "Simulation.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "Physics/Gravity.h"
+
+Simulation::Simulation(const std::vector<Planet>& planets, const Star& sun) {
+    for (const Planet& planet : planets)
+        state.push_back(BodyState{planet.position, planet.velocity, planet.mass});
+    state.push_back(BodyState{sun.position, sun.velocity, sun.mass});
+    predictedCount = planets.size();
+    orbits.resize(state.size());
+
+    // Readers may acquire before the first step completes
+    publish(false);
+}
+
+Simulation::~Simulation() { stop(); }
+
+void Simulation::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+}
+
+void Simulation::run() {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<float>(1.0f / STEP_RATE));
+    // Past this much lag the clock is reset instead of caught up
+    const Clock::duration maxLag = period * 15;
+
+    Clock::time_point next = Clock::now();
+    Clock::time_point rateStart = next;
+    unsigned int rateSteps = 0;
+
+    while (running.load(std::memory_order_relaxed)) {
+        next += period;
+
+        Clock::time_point begin = Clock::now();
+        bool predict = predictOrbits.load(std::memory_order_relaxed);
+        step(stepDelta(), predict);
+        publish(predict);
+        Clock::time_point end = Clock::now();
+
+        std::chrono::duration<float, std::milli> elapsed = end - begin;
+        measuredStepTime.store(elapsed.count(), std::memory_order_relaxed);
+        rateSteps++;
+        if (end - rateStart >= std::chrono::seconds(1)) {
+            std::chrono::duration<float> window = end - rateStart;
+            measuredRate.store(rateSteps / window.count(), std::memory_order_relaxed);
+            rateStart = end;
+            rateSteps = 0;
+        }
+
+        if (end - next > maxLag) next = end;
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void Simulation::advance(unsigned int count) {
+    if (running.load(std::memory_order_relaxed) || count == 0) return;
+
+    auto begin = std::chrono::steady_clock::now();
+    // Only the last step's prediction is published, so only it is computed
+    bool predict = predictOrbits.load(std::memory_order_relaxed);
+    for (unsigned int i = 0; i < count; i++)
+        step(stepDelta(), predict && i + 1 == count);
+    publish(predict);
+
+    std::chrono::duration<float, std::milli> elapsed =
+        std::chrono::steady_clock::now() - begin;
+    measuredStepTime.store(elapsed.count() / count, std::memory_order_relaxed);
+}
+
+// Acceleration at a point from every body but one, as Gravity::acceleration
+glm::vec3 Simulation::acceleration(const glm::vec3& position, size_t exclude) const {
+    glm::vec3 netAcc(0.0f);
+    for (size_t i = 0; i < state.size(); i++) {
+        if (i == exclude) continue;
+
+        glm::vec3 distance_vector = state[i].position - position;
+        float r2 = glm::dot(distance_vector, distance_vector);
+        if (r2 <= 0.0f) continue;
+
+        netAcc += (Gravity::G * state[i].mass / r2) *
+                  glm::normalize(distance_vector);
+    }
+    return netAcc;
+}
+
+// Extrapolates one body through the current field, the others held still
+void Simulation::predict(size_t index, float timestep, unsigned int count,
+                         std::vector<GLfloat>& path) const {
+    glm::vec3 pos = state[index].position;
+    glm::vec3 vel = state[index].velocity;
+
+    path.clear();
+    path.reserve(count * 3 + 3);
+    path.push_back(pos.x);
+    path.push_back(pos.y);
+    path.push_back(pos.z);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        vel += acceleration(pos, index) * timestep;
+        pos += vel * timestep;
+        path.push_back(pos.x);
+        path.push_back(pos.y);
+        path.push_back(pos.z);
+    }
+}
+
+float Simulation::stepDelta() const {
+    if (paused.load(std::memory_order_relaxed)) return 0.0f;
+    return timeMultiplier.load(std::memory_order_relaxed) / STEP_RATE;
+}
+
+void Simulation::step(float delta_time, bool predict) {
+    // In order, each body sees the ones before it already moved
+    for (size_t i = 0; i < state.size(); i++) {
+        BodyState& body = state[i];
+        body.velocity += acceleration(body.position, i) * delta_time;
+        body.position += body.velocity * delta_time;
+
+        if (predict && i < predictedCount)
+            this->predict(i, 1000.0f, 300, orbits[i]);
+    }
+
+    time += delta_time;
+    // Spin follows the sign of the step, so it reverses with time and stops
+    // with it, at the same on-screen speed whatever the multiplier
+    if (delta_time != 0.0f)
+        clock += std::copysign(1.0, (double)delta_time) / STEP_RATE;
+    steps++;
+}
+
+void Simulation::publish(bool predicted) {
+    SimulationSnapshot& snapshot = snapshots.back();
+
+    // Assignment reuses the capacity the slot kept from its last publish
+    snapshot.bodies = state;
+    snapshot.orbits.resize(state.size());
+    for (size_t i = 0; i < state.size(); i++) {
+        if (predicted)
+            snapshot.orbits[i] = orbits[i];
+        else
+            snapshot.orbits[i].clear();
+    }
+    snapshot.time = time;
+    snapshot.clock = clock;
+    snapshot.step = steps;
+
+    snapshots.publish();
+}
+
+void Simulation::apply(const std::vector<Body*>& bodies) const {
+    const SimulationSnapshot& current = snapshot();
+
+    for (size_t i = 0; i < bodies.size() && i < current.bodies.size(); i++) {
+        bodies[i]->position = current.bodies[i].position;
+        bodies[i]->velocity = current.bodies[i].velocity;
+        bodies[i]->mass = current.bodies[i].mass;
+        bodies[i]->setOrbit(current.orbits[i]);
+    }
+}
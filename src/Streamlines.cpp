@@ -0,0 +1,225 @@
+#include "Streamlines.h"
+#include "Renderer/GLState.h"
+#include "utils/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+
+// Lines advanced together per job; their field evaluations share one batch call
+static const size_t BATCH_SIZE = 32;
+
+Streamlines::Streamlines() { initVertexData(); }
+
+void Streamlines::update(const Camera& camera, const std::vector<Body*>& bodies,
+                         GLfloat extent, GLfloat height) {
+    if (bodies.empty()) return;
+
+    TraceKey key;
+    key.seedMode = seedMode;
+    key.seedsPerSide = std::max(seedsPerSide, 1);
+    key.seedsAroundBody = std::max(seedsAroundBody, 1);
+    key.seedBody =
+        std::min(std::max(seedBody, 0), static_cast<int>(bodies.size()) - 1);
+    key.maxSteps = std::max(maxSteps, 1);
+    key.seedRadius = seedRadius;
+    key.stepTolerance = stepTolerance;
+    for (const Body* body : bodies) {
+        key.positions.push_back(body->position);
+        key.masses.push_back(body->mass);
+    }
+
+    float spacing;
+    if (key.seedMode == SEED_GRID) {
+        spacing = extent / key.seedsPerSide;
+        // Snap to the seed lattice so camera motion alone rarely forces a retrace
+        glm::vec3 cam = camera.Position;
+        key.origin = glm::vec3(floorf(cam.x / spacing) * spacing, height,
+                               floorf(cam.z / spacing) * spacing);
+    } else {
+        spacing = glm::two_pi<float>() * seedRadius / key.seedsAroundBody;
+        key.origin = bodies[key.seedBody]->position;
+    }
+
+    if (!needsRetrace(key, spacing)) return;
+
+    seeds.clear();
+    if (key.seedMode == SEED_GRID) {
+        glm::vec3 corner = key.origin - glm::vec3(extent / 2.0f, 0.0f, extent / 2.0f);
+        for (int i = 0; i < key.seedsPerSide; i++)
+            for (int j = 0; j < key.seedsPerSide; j++)
+                seeds.push_back(corner + glm::vec3((i + 0.5f) * spacing, 0.0f,
+                                                   (j + 0.5f) * spacing));
+    } else {
+        for (int i = 0; i < key.seedsAroundBody; i++) {
+            float angle = glm::two_pi<float>() * i / key.seedsAroundBody;
+            seeds.push_back(key.origin +
+                            seedRadius * glm::vec3(cosf(angle), 0.0f, sinf(angle)));
+        }
+    }
+
+    sources.assign(bodies);
+
+    size_t lines = seeds.size();
+    size_t lineCapacity = key.maxSteps + 1;
+    counts.assign(lines, 0);
+
+    // The lines stay in this stream region until the next retrace
+    GLsizeiptr bytes = lines * lineCapacity * 3 * sizeof(GLfloat);
+    GLfloat* mapped = static_cast<GLfloat*>(this->stream.map(bytes));
+    if (mapped == nullptr) {
+        counts.clear();
+        return;
+    }
+
+    firsts.resize(lines);
+    for (size_t l = 0; l < lines; l++)
+        firsts[l] = this->stream.first() + static_cast<GLint>(l * lineCapacity);
+
+    // Grid seeds follow the field into the bodies; body seeds trace it backwards
+    // so the lines fan out from the chosen body
+    float direction = key.seedMode == SEED_GRID ? 1.0f : -1.0f;
+    float stopRadius = 0.25f * spacing;
+    size_t batches = (lines + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    ThreadPool::get().parallelFor(batches, [&](size_t batch) {
+        size_t first = batch * BATCH_SIZE;
+        traceBatch(key, first, std::min(BATCH_SIZE, lines - first), direction, extent,
+                   stopRadius, mapped);
+    });
+
+    if (!this->stream.unmap()) counts.clear();
+    bindStream();
+
+    traced = std::move(key);
+    retraces++;
+}
+
+bool Streamlines::needsRetrace(const TraceKey& key, float spacing) const {
+    if (key.seedMode != traced.seedMode || key.seedsPerSide != traced.seedsPerSide ||
+        key.seedsAroundBody != traced.seedsAroundBody ||
+        key.seedBody != traced.seedBody || key.maxSteps != traced.maxSteps ||
+        key.seedRadius != traced.seedRadius ||
+        key.stepTolerance != traced.stepTolerance ||
+        key.positions.size() != traced.positions.size())
+        return true;
+
+    float tolerance = recomputeTolerance * spacing;
+    if (glm::length(key.origin - traced.origin) > tolerance) return true;
+
+    for (size_t i = 0; i < key.positions.size(); i++) {
+        if (key.masses[i] != traced.masses[i]) return true;
+        if (glm::length(key.positions[i] - traced.positions[i]) > tolerance)
+            return true;
+    }
+    return false;
+}
+
+void Streamlines::traceBatch(const TraceKey& key, size_t firstLine, size_t batchSize,
+                             float direction, float extent, float stopRadius,
+                             GLfloat* out) {
+    const size_t lineCapacity = key.maxSteps + 1;
+    const float maxStep = extent / 50.0f;
+    const float minStep = maxStep * 1.0e-3f;
+    const float tolerance = std::max(key.stepTolerance, 1.0e-6f);
+
+    glm::vec3 position[BATCH_SIZE], k1[BATCH_SIZE], k2[BATCH_SIZE];
+    glm::vec3 probe[BATCH_SIZE], field[BATCH_SIZE];
+    float step[BATCH_SIZE], nearest2[BATCH_SIZE];
+    size_t active[BATCH_SIZE];
+    size_t activeCount = 0;
+
+    auto emit = [&](size_t line) {
+        size_t index = firstLine + line;
+        GLfloat* vertex = out + (index * lineCapacity + counts[index]) * 3;
+        vertex[0] = position[line].x;
+        vertex[1] = position[line].y;
+        vertex[2] = position[line].z;
+        counts[index]++;
+    };
+
+    for (size_t line = 0; line < batchSize; line++) {
+        position[line] = seeds[firstLine + line];
+        step[line] = 0.1f * maxStep;
+        emit(line);
+        active[activeCount++] = line;
+    }
+
+    // Each pass evaluates both Heun stages for every live line in one batch call.
+    // Rejected steps retry with a smaller step, so bound the passes generously.
+    for (int pass = 0; pass < key.maxSteps * 4 && activeCount > 0; pass++) {
+        for (size_t a = 0; a < activeCount; a++) probe[a] = position[active[a]];
+        Gravity::accelerationBatch(sources, probe, field, nearest2, activeCount);
+
+        size_t live = 0;
+        for (size_t a = 0; a < activeCount; a++) {
+            size_t line = active[a];
+            float magnitude = glm::length(field[a]);
+            if (magnitude == 0.0f || nearest2[a] < stopRadius * stopRadius) continue;
+
+            k1[line] = field[a] * (direction / magnitude);
+            probe[live] = position[line] + step[line] * k1[line];
+            active[live++] = line;
+        }
+        activeCount = live;
+
+        Gravity::accelerationBatch(sources, probe, field, nullptr, activeCount);
+
+        live = 0;
+        for (size_t a = 0; a < activeCount; a++) {
+            size_t line = active[a];
+            float magnitude = glm::length(field[a]);
+            k2[line] = magnitude > 0.0f ? field[a] * (direction / magnitude) : k1[line];
+
+            // Euler vs. Heun difference estimates the local error of the step
+            float h = step[line];
+            float error = 0.5f * h * glm::length(k2[line] - k1[line]);
+            float scale = 0.9f * sqrtf(tolerance / std::max(error, 1.0e-12f));
+
+            if (error > tolerance && h > minStep) {
+                step[line] = std::max(minStep, h * std::max(scale, 0.2f));
+                active[live++] = line;
+                continue;
+            }
+
+            position[line] += 0.5f * h * (k1[line] + k2[line]);
+            emit(line);
+            step[line] = glm::clamp(h * std::min(scale, 2.0f), minStep, maxStep);
+
+            bool inside = glm::length(position[line] - key.origin) < extent;
+            if (inside && counts[firstLine + line] < static_cast<GLsizei>(lineCapacity))
+                active[live++] = line;
+        }
+        activeCount = live;
+    }
+}
+
+void Streamlines::render(const Shader& shader, GLfloat mapSize) {
+    if (counts.empty()) return;
+
+    GLState::get().bindVertexArray(this->VAO);
+
+    glm::mat4 model(1.0f);
+    shader.setMat4("model", model);
+    shader.setVec3("gridColor", this->color);
+    shader.setFloat("mapSize", mapSize);
+
+    GLState::get().lineWidth(1.0f);
+    glMultiDrawArrays(GL_LINE_STRIP, firsts.data(), counts.data(),
+                      static_cast<GLsizei>(counts.size()));
+}
+
+void Streamlines::initVertexData() {
+    // The vertex attribute is pointed at the stream once it has a buffer
+    glGenVertexArrays(1, &this->VAO);
+}
+
+void Streamlines::bindStream() {
+    if (this->stream.generation() == this->streamGeneration) return;
+
+    GLState::get().bindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->stream.buffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    this->streamGeneration = this->stream.generation();
+}
@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -13,10 +16,31 @@
 #include <ostream>
 #include <vector>
 
+#include "AsteroidBelt.h"
 #include "Camera.h"
 #include "Celestial_Body.h"
 #include "GravityWell.h"
+#include "IsoContours.h"
+#include "Renderer/Atmosphere.h"
+#include "Renderer/BodyLabels.h"
+#include "Renderer/BodyRenderer.h"
+#include "Renderer/ClusteredLights.h"
+#include "Renderer/DynamicResolution.h"
+#include "Renderer/EclipseShadows.h"
+#include "Renderer/FrameCapture.h"
+#include "Renderer/FrameUniforms.h"
+#include "Renderer/GLExt.h"
+#include "Renderer/GLState.h"
+#include "Renderer/HeadlessContext.h"
+#include "Renderer/PlanetSurfaces.h"
+#include "Renderer/ProgramCache.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/SphereBVH.h"
+#include "Renderer/Starfield.h"
 #include "Renderer/Shader.h"
+#include "RotatingFrame.h"
+#include "Simulation.h"
+#include "Streamlines.h"
 
 #include "Settings.h"
 #include "imgui.h"
@@ -47,44 +71,103 @@ bool firstMouse = true;
 
 // Time
 float delta_time = 0.0f;
-float sim_delta_time = 0.0f;
 
-int main() {
-    // glfw: initialize and configure
+int main(int argc, char **argv) {
+    // --gl33 keeps to the 3.3 core renderer even where 4.5 is available.
+    // --headless renders without a window for --frames frames, and --capture
+    // records raw RGBA video to a file or, after a '|', to a command's stdin.
+    // --stars names the star catalog drawn as the sky. --linear-depth builds the
+    // programs without logarithmic depth.
+    bool allow_gl45 = true;
+    bool headless = false;
+    long max_frames = 600;
+    const char *capture_path = nullptr;
+    const char *catalog_path = "../assets/catalog/stars.txt";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--gl33") == 0) allow_gl45 = false;
+        if (strcmp(argv[i], "--headless") == 0) headless = true;
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            max_frames = atol(argv[++i]);
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+            capture_path = argv[++i];
+        if (strcmp(argv[i], "--stars") == 0 && i + 1 < argc)
+            catalog_path = argv[++i];
+        if (strcmp(argv[i], "--linear-depth") == 0)
+            Settings::get().logarithmicDepth = false;
+    }
+
+    // glfw: initialize and configure. Headless runs never touch GLFW: EGL
+    // gives them a context and frames are timed by their count.
     // ------------------------------
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    if (!headless) {
+        if (!glfwInit()) {
+            cout << "Failed to initialize GLFW" << endl;
+            return -1;
+        }
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    }
+    // Terminates GLFW on every way out of main, after everything declared below
+    // has released its GL objects while the context was still current
+    struct GlfwSession {
+        bool active;
+        ~GlfwSession() {
+            if (active) glfwTerminate();
+        }
+    } glfw_session{!headless};
 
-    // glfw window creation
+    // glfw window creation: 4.5 for direct state access and persistent mapping,
+    // falling back to 3.3 where the driver cannot create it
     // --------------------
-    GLFWwindow *window = glfwCreateWindow(screen_width, screen_height, "Planet Sim",
-                                          nullptr, nullptr);
-    if (window == nullptr) {
+    GLFWwindow *window = nullptr;
+    HeadlessContext Headless;
+    GLADloadproc gl_loader = (GLADloadproc)glfwGetProcAddress;
+    if (headless) {
+        if (!Headless.create(allow_gl45)) {
+            cout << "Failed to create headless context" << endl;
+            return -1;
+        }
+        gl_loader = HeadlessContext::loadProc;
+    }
+    if (!headless && allow_gl45) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        window = glfwCreateWindow(screen_width, screen_height, "Planet Sim", nullptr,
+                                  nullptr);
+    }
+    if (!headless && window == nullptr) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(screen_width, screen_height, "Planet Sim", nullptr,
+                                  nullptr);
+    }
+    if (!headless && window == nullptr) {
         cout << "Failed to create GLFW window" << endl;
-        glfwTerminate();
         return -1;
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, mouse_scroll_callback);
-    // glfwSetMouseButtonCallback(window, mouse_button_callback);
-    // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSwapInterval(0);
+    if (!headless) {
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, mouse_scroll_callback);
+        // glfwSetMouseButtonCallback(window, mouse_button_callback);
+        // glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSwapInterval(0);
+    }
 
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    if (!gladLoadGLLoader(gl_loader)) {
         cout << "Failed to initialize GLAD" << endl;
         return -1;
     }
+    // Must come before anything creates buffers
+    GLExt::load(gl_loader, allow_gl45);
+    if (headless) Headless.createFramebuffer(screen_width, screen_height);
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -95,26 +178,54 @@ int main() {
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;  // Enable Gamepad Controls
     io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;     // IF using Docking Branch
 
-    // Setup Platform/Renderer backends
-    ImGui_ImplGlfw_InitForOpenGL(
-        window, true);  // Second param install_callback=true will install GLFW
-                        // callbacks and chain to existing ones.
+    // Setup Platform/Renderer backends. Headless runs still build the panels,
+    // they are just never drawn.
+    if (!headless)
+        ImGui_ImplGlfw_InitForOpenGL(
+            window, true);  // Second param install_callback=true will install GLFW
+                            // callbacks and chain to existing ones.
     ImGui_ImplOpenGL3_Init();
     //
 
-    // build and compile our shader program
+    // build and compile our shader program, in the logarithmic depth variant
+    // unless --linear-depth asked for the projection's own depth
     // ------------------------------------
+    const string depth_variant =
+        Settings::get().logarithmicDepth ? "#define LOG_DEPTH\n" : "";
     Shader DefaultShader("../assets/shaders/default.vert",
-                         "../assets/shaders/default.frag");
-    Shader PlanetShader("../assets/shaders/planet.vs",
-                        "../assets/shaders/planet.fs");
+                         "../assets/shaders/default.frag", depth_variant);
+    Shader PlanetShader("../assets/shaders/planet.vs", "../assets/shaders/planet.fs",
+                        depth_variant);
+    Shader ImpostorShader("../assets/shaders/impostor.vs",
+                          "../assets/shaders/impostor.fs", depth_variant);
+    Shader PointShader("../assets/shaders/point_sprite.vs",
+                       "../assets/shaders/point_sprite.fs", depth_variant);
+    Shader StarfieldShader("../assets/shaders/starfield.vs",
+                           "../assets/shaders/point_sprite.fs", depth_variant);
+    Shader AtmosphereShader("../assets/shaders/planet_atmosphere.vs",
+                            "../assets/shaders/planet_atmosphere.fs", depth_variant);
     Shader GravityWellShader("../assets/shaders/gravity_well.vs",
-                             "../assets/shaders/gravity_well.fs");
-
-    vector<Planet> planets = {Planet(vec3(-2000.0f, 0.0f, 0.0f),
-                                     vec3(0.0f, 0.0f, 0.03f), 5000.0e5f, 100.492f),
-                              Planet(vec3(-2300.0f, 0.0f, 0.0f),
-                                     vec3(0.0f, 0.0f, 0.02f), 5000.0f, 25.492f)};
+                             "../assets/shaders/gravity_well.fs", depth_variant);
+    Shader GravityWellMapShader("../assets/shaders/gravity_well_map.vs",
+                                "../assets/shaders/gravity_well_map.fs", depth_variant);
+    ClusteredLights::attach(PlanetShader);
+    ClusteredLights::attach(ImpostorShader);
+    EclipseShadows::attach(PlanetShader);
+    EclipseShadows::attach(ImpostorShader);
+    PlanetSurfaces::attach(PlanetShader);
+    PlanetSurfaces::attach(ImpostorShader);
+    const ProgramCache &Programs = ProgramCache::get();
+    cout << "Shaders: " << Programs.totalTime() << " ms, " << Programs.hitCount()
+         << " cached, " << Programs.missCount() << " compiled, saved "
+         << Programs.savedTime() << " ms" << endl;
+
+    // Bodies own GL objects and cannot be copied, so they are built in place
+    vector<Planet> planets;
+    planets.reserve(2);
+    planets.emplace_back(vec3(-2000.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.03f),
+                         5000.0e5f, 100.492f);
+    planets.emplace_back(vec3(-2300.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.02f),
+                         5000.0f, 25.492f);
 
     vector<Body *> bodies;
     for (auto &planet : planets) {
@@ -124,38 +235,142 @@ int main() {
     Star sun(vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 0.0f), 250.0e8f, 696.340f);
     bodies.push_back(&sun);
 
+    sun.name = "Sun";
+    for (size_t i = 0; i < planets.size(); i++)
+        planets[i].name = "Planet " + to_string(i + 1);
+
+    // One procedural surface per planet, seeded by its index
+    PlanetSurfaces Surfaces;
+    vector<float> surface_layers;
+    for (size_t i = 0; i < planets.size(); i++)
+        surface_layers.push_back(Surfaces.add((uint32_t)i + 1));
+    Surfaces.build();
+    cout << "Surfaces: " << Surfaces.size() << " (" << Surfaces.cachedCount()
+         << " cached) in " << Surfaces.buildTime() << " ms" << endl;
+
+    // Scattering tables are shared by every planet's atmosphere
+    Atmosphere Air;
+    Air.load();
+    cout << "Atmosphere: tables " << (Air.fromCache() ? "loaded" : "built") << " in "
+         << Air.loadTime() << " ms" << endl;
+
+    Starfield Sky;
+    if (Sky.load(catalog_path))
+        cout << "Starfield: " << Sky.size() << " stars "
+             << (Sky.fromCache() ? "from cache" : "parsed") << " in " << Sky.loadTime()
+             << " ms" << endl;
+    else
+        cout << "Starfield: no catalog at " << catalog_path << endl;
+
     GravityWell GravityWell(50);
+    IsoContours Contours;
+    Streamlines FieldLines;
+
+    RotatingFrame Frame;
+    BodyRenderer Bodies;
+    BodyLabels Labels;
+    FrameUniforms FrameBlock;
+    FrameData frame_data = {};
+    Uniform<float> point_limit = PointShader.uniform<float>("limitingMagnitude");
+    Uniform<float> point_max_size = PointShader.uniform<float>("maxPointSize");
+    AsteroidBelt Belt;
+    SphereBVH BodyTree;
+    vector<vec3> body_centers;
+    vector<float> body_radii;
+    vector<uint32_t> visible_bodies;
+    unsigned int visible_orbits = 0;
+    int belt_count = 100000;
+    // Demo stars scattered around the system to exercise the light clusters
+    ClusteredLights Lights;
+    EclipseShadows Shadows;
+    int extra_star_count = 0;
+    float extra_star_range = 1500.0f;
+    vector<vec3> extra_star_centers;
+    vector<float> extra_star_radii;
+    vector<vec3> extra_star_colors;
+    Frame.primary = static_cast<int>(bodies.size()) - 1;
+    Frame.secondary = 0;
+
+    // Physics runs on its own thread at a fixed rate; each frame draws the
+    // newest state it has published. Headless runs step it in lockstep
+    // instead, the steps of one video frame per frame, so captures are the same
+    // on every run however slowly they render.
+    const float video_rate = 60.0f;
+    const unsigned int steps_per_frame =
+        std::max(1u, (unsigned int)(Simulation::STEP_RATE / video_rate + 0.5f));
+    Simulation Sim(planets, sun);
+    if (!headless) Sim.start();
 
     // MAIN RENDER LOOP
-    float prev_time = static_cast<float>(glfwGetTime());
-    float accumulator = 0.0f;
+    float prev_time = headless ? 0.0f : static_cast<float>(glfwGetTime());
     float accumulator_30fps = 0.0f;
-    float fixed_time_step = 1.0f / 60.0f;
-    float time_multplier = 10000.0f;
+    float time_multplier = Sim.timeMultiplier;
 
     camera.MovementSpeed = 100.0f;
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    while (!glfwWindowShouldClose(window)) {
-        // Timing
-        float curr_time = static_cast<float>(glfwGetTime());
+    // Render states of the draw passes, applied by the render queue
+    RenderQueue Queue;
+    DynamicResolution Resolution;
+    FrameCapture Capture;
+    if (headless) {
+        // Video wants every frame at full resolution
+        Resolution.enabled = false;
+        Resolution.outputFramebuffer = Headless.framebuffer();
+    }
+    if (capture_path != nullptr) {
+        int capture_width = screen_width, capture_height = screen_height;
+        if (!headless) glfwGetFramebufferSize(window, &capture_width, &capture_height);
+        if (!Capture.open(capture_path, Resolution.outputFramebuffer, capture_width,
+                          capture_height))
+            cout << "Failed to open capture " << capture_path << endl;
+    }
+    long frame_count = 0;
+    RenderState opaque;
+    RenderState blended;
+    blended.blend = RenderState::BLEND_ALPHA;
+    RenderState additive;
+    additive.blend = RenderState::BLEND_ADDITIVE;
+    additive.depthWrite = false;
+    additive.programPointSize = true;
+    RenderState premultiplied;
+    premultiplied.blend = RenderState::BLEND_PREMULTIPLIED;
+    premultiplied.depthWrite = false;
+
+    while (headless ? frame_count < max_frames : !glfwWindowShouldClose(window)) {
+        // Timing: headless frames are spaced for video however long they take
+        // to render
+        float curr_time = headless ? frame_count / video_rate
+                                   : static_cast<float>(glfwGetTime());
         delta_time = curr_time - prev_time;
-        sim_delta_time = fixed_time_step * time_multplier;
         prev_time = curr_time;
 
-        accumulator += delta_time;
         accumulator_30fps += delta_time;
         //
 
-        processInput(window);
+        if (!headless) processInput(window);
+
+        // The scene renders offscreen at a scale that holds the frame budget
+        int framebuffer_width = screen_width, framebuffer_height = screen_height;
+        if (!headless)
+            glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+        Resolution.resize(framebuffer_width, framebuffer_height);
+        Resolution.begin();
+
+        GLState::get().resetCounters();
+        // The last pass may have left depth writes off, which would also mask
+        // the depth clear
+        GLState::get().depthMask(true);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
+        if (headless) {
+            io.DisplaySize = ImVec2((float)screen_width, (float)screen_height);
+            io.DeltaTime = delta_time > 0.0f ? delta_time : 1.0f / 60.0f;
+        } else {
+            ImGui_ImplGlfw_NewFrame();
+        }
         ImGui::NewFrame();
         //
 
@@ -171,113 +386,394 @@ int main() {
         if (ImGui::Button(paused ? "Play" : "Pause")) {
             paused = !paused;
         }
-        if (paused) sim_delta_time = 0.0f;
 
         ImGui::Spacing();
         ImGui::Text("Gravity Well");
         ImGui::Separator();
         ImGui::Checkbox("Show Grid", &Settings::get().showGravityWell);
         ImGui::DragFloat("Grid Size", &GravityWell.gridSize, 10.0f, 100.0f);
+        ImGui::DragFloat("Dirty Tolerance", &GravityWell.dirtyTolerance, 0.001f, 0.0f,
+                         1.0f);
+        ImGui::Text("Tiles Updated: %u / %u", GravityWell.dirtyTileCount(),
+                    GravityWell.tileCount());
+        ImGui::Combo("Renderer", &GravityWell.renderMode, "Lines\0Height Map\0");
+        if (GravityWell.renderMode == GravityWell::RENDER_HEIGHTMAP) {
+            ImGui::SliderInt("Mesh Resolution", &GravityWell.meshResolution, 16, 1024);
+            ImGui::Checkbox("Slope Colouring", &GravityWell.slopeShading);
+            ImGui::DragFloat("Slope Scale", &GravityWell.slopeScale, 0.05f, 0.0f,
+                             100.0f);
+        }
+        ImGui::Checkbox("Show Contours", &Settings::get().showContours);
+        ImGui::SliderInt("Contour Levels", &Contours.levelCount, 1, 64);
+        ImGui::Text("Contour Segments: %zu", Contours.segmentCount());
+        ImGui::Text("Co-Rotating Frame");
+        ImGui::Separator();
+        ImGui::Checkbox("Effective Potential", &Settings::get().showRotatingFrame);
+        ImGui::SliderInt("Primary", &Frame.primary, 0,
+                         static_cast<int>(bodies.size()) - 1);
+        ImGui::SliderInt("Secondary", &Frame.secondary, 0,
+                         static_cast<int>(bodies.size()) - 1);
+        ImGui::Text("Lagrange Solves: %u", Frame.solveCount());
+        ImGui::Text("Field Lines");
+        ImGui::Separator();
+        ImGui::Checkbox("Show Field Lines", &Settings::get().showStreamlines);
+        ImGui::Combo("Seeding", &FieldLines.seedMode, "Grid\0Around Body\0");
+        if (FieldLines.seedMode == Streamlines::SEED_GRID)
+            ImGui::SliderInt("Seeds Per Side", &FieldLines.seedsPerSide, 2, 64);
+        else {
+            ImGui::SliderInt("Seed Body", &FieldLines.seedBody, 0,
+                             static_cast<int>(bodies.size()) - 1);
+            ImGui::SliderInt("Seeds", &FieldLines.seedsAroundBody, 4, 512);
+            ImGui::DragFloat("Seed Radius", &FieldLines.seedRadius, 10.0f, 10.0f,
+                             5000.0f);
+        }
+        ImGui::SliderInt("Max Steps", &FieldLines.maxSteps, 10, 1000);
+        ImGui::DragFloat("Step Tolerance", &FieldLines.stepTolerance, 0.05f, 0.01f,
+                         100.0f);
+        ImGui::Text("Lines: %zu, Retraces: %u", FieldLines.lineCount(),
+                    FieldLines.retraceCount());
         ImGui::Text("Planets");
         ImGui::Separator();
         ImGui::Checkbox("Show Orbit", &Settings::get().showOrbit);
-        if (paused) sim_delta_time = 0.0f;
+        ImGui::Text("Asteroid Belt");
+        ImGui::Separator();
+        ImGui::Checkbox("Show Belt", &Settings::get().showBelt);
+        ImGui::SliderInt("Asteroids", &belt_count, 1000, 1000000, "%d",
+                         ImGuiSliderFlags_Logarithmic);
+        if (Settings::get().showBelt && Belt.size() != (size_t)belt_count)
+            Belt.resize(belt_count);
+        ImGui::Text("Sky");
+        ImGui::Separator();
+        ImGui::Checkbox("Show Starfield", &Settings::get().showStarfield);
+        ImGui::SliderFloat("Sky Exposure", &Sky.exposure, 0.01f, 100.0f, "%.2f",
+                           ImGuiSliderFlags_Logarithmic);
+        ImGui::Text("Limiting Magnitude: %.1f", Sky.limitingMagnitude());
+        ImGui::Text("Labels");
+        ImGui::Separator();
+        ImGui::Checkbox("Show Labels", &Settings::get().showLabels);
+        ImGui::Checkbox("Label Asteroids", &Settings::get().labelAsteroids);
+        ImGui::Text("Labels: %zu of %zu", Labels.labelCount(), Labels.candidateCount());
+        ImGui::Text("Lighting");
+        ImGui::Separator();
+        ImGui::SliderInt("Extra Stars", &extra_star_count, 0, 1000);
+        ImGui::DragFloat("Star Light Range", &extra_star_range, 10.0f, 10.0f, 20000.0f);
+        ImGui::Checkbox("Eclipse Shadows", &Settings::get().eclipseShadows);
+        ImGui::Checkbox("Atmospheres", &Settings::get().showAtmosphere);
+        ImGui::Checkbox("Planet Surfaces", &Settings::get().planetSurfaces);
+        ImGui::SliderFloat("Sun Radiance", &Air.intensity, 1.0f, 50.0f);
+        if (extra_star_centers.size() != (size_t)extra_star_count) {
+            // Seeded, so growing the count keeps the stars already placed
+            srand(7);
+            extra_star_centers.clear();
+            extra_star_radii.clear();
+            extra_star_colors.clear();
+            for (int i = 0; i < extra_star_count; i++) {
+                float angle = radians(360.0f) * rand() / RAND_MAX;
+                float distance = 1000.0f + 5000.0f * rand() / RAND_MAX;
+                float height = 400.0f * (2.0f * rand() / RAND_MAX - 1.0f);
+                extra_star_centers.push_back(
+                    vec3(distance * cos(angle), height, distance * sin(angle)));
+                extra_star_radii.push_back(10.0f + 30.0f * rand() / RAND_MAX);
+                float warmth = static_cast<float>(rand()) / RAND_MAX;
+                extra_star_colors.push_back(
+                    mix(vec3(0.6f, 0.7f, 1.0f), vec3(1.0f, 0.6f, 0.3f), warmth));
+            }
+        }
+
+        Sim.timeMultiplier = time_multplier;
+        Sim.paused = paused;
+        Sim.predictOrbits = Settings::get().showOrbit;
 
         ImGui::End();
         //
 
-        // Simulation Step
-        while (accumulator >= fixed_time_step) {
-            for (unsigned int i = 0; i < planets.size(); i++) {
-                planets[i].update(bodies, sim_delta_time);
-            }
-
-            sun.update(bodies, sim_delta_time);
-
-            accumulator -= fixed_time_step;
+        // Simulation State
+        if (headless) Sim.advance(steps_per_frame);
+        if (Sim.acquire()) {
+            Sim.apply(bodies);
+            Belt.setTime(Sim.snapshot().time);
 
             camera.LookAt(planets[1].position);
-
-            cout << accumulator << endl;
         }
         if (accumulator_30fps >= 1.0f / 30.0f) {
-            if (Settings::get().showGravityWell)
-                GravityWell.updateVertexData(camera, bodies);
+            const RotatingFrame *frame = nullptr;
+            if (Settings::get().showRotatingFrame && Frame.update(bodies))
+                frame = &Frame;
+
+            // Zero-velocity curves pass through L1, L2 and L3
+            Contours.pinnedDepths.clear();
+            for (int i = 0; i < 3 && frame != nullptr; i++)
+                Contours.pinnedDepths.push_back(frame->lagrangeDepth(i) *
+                                                GravityWell.depthScale);
+
+            if (Settings::get().showGravityWell) {
+                GravityWell.updateVertexData(camera, bodies, frame);
+                if (Settings::get().showContours) Contours.update(GravityWell);
+            }
+            if (Settings::get().showStreamlines)
+                FieldLines.update(camera, bodies, GravityWell.mapSize, sun.position.y);
 
             accumulator_30fps = 0;
         }
-        cout << "---------------------" << endl;
         //
 
         // Camera Matrix
         mat4 view = camera.GetViewMatrix();
+        // One pass covers the whole range; logarithmic depth keeps it precise
+        const float near_plane = 0.1f, far_plane = 1000000.0f;
         mat4 projection =
             perspective(radians(50.0f), (float)screen_width / (float)screen_height,
-                        0.1f, 1000000.0f);
+                        near_plane, far_plane);
+
+        // Per-frame uniforms, shared by every shader through the Frame block
+        frame_data.view = view;
+        frame_data.projection = projection;
+        frame_data.cameraPos = camera.Position;
+        frame_data.time = curr_time;
+        frame_data.lightPosition = sun.position;
+        frame_data.lightAmbient = vec3(0.0f);
+        // Light colours come from the clusters, see below
+        frame_data.lightDiffuse = vec3(1.0f);
+        frame_data.lightSpecular = vec3(0.1f);
+        frame_data.logDepth = 1.0f / std::log2(far_plane + 1.0f);
+        FrameBlock.upload(frame_data);
+
+        // Lights: bin every star into the froxels of the scene viewport
+        Lights.begin();
+        Lights.add(sun.position, sun.color, 1.0e5f, true);
+        for (size_t i = 0; i < extra_star_centers.size(); i++)
+            Lights.add(extra_star_centers[i], extra_star_colors[i], extra_star_range);
+        Lights.build(view, projection, near_plane, far_plane, Resolution.sceneWidth(),
+                     Resolution.sceneHeight());
+        Lights.bind();
+        Surfaces.bind();
+        for (size_t i = 0; i < planets.size(); i++)
+            planets[i].surfaceLayer =
+                Settings::get().planetSurfaces ? surface_layers[i] : 0.0f;
+
+        // Shadows: every planet can eclipse the sun for every other
+        Shadows.begin(sun.position, sun.boundingRadius());
+        for (const Planet &planet : planets)
+            Shadows.addOccluder(planet.position, planet.boundingRadius());
+        for (size_t i = 0; i < planets.size(); i++)
+            planets[i].shadowList =
+                Settings::get().eclipseShadows
+                    ? Shadows.addReceiver(planets[i].position,
+                                          planets[i].boundingRadius(), (int)i)
+                    : 0.0f;
+        Shadows.upload();
+
+        // Visibility: refit the body hierarchy and cull it against the view
+        Bodies.setView(camera, view, projection, (float)Resolution.sceneHeight());
+        const Frustum &frustum = Bodies.frustum();
+        bool culling = Settings::get().frustumCulling;
+
+        body_centers.clear();
+        body_radii.clear();
+        for (const Body *body : bodies) {
+            body_centers.push_back(body->position);
+            body_radii.push_back(body->boundingRadius());
+        }
+        if (BodyTree.size() != bodies.size() || BodyTree.needsRebuild())
+            BodyTree.build(body_centers.data(), body_radii.data(), bodies.size());
+        else
+            BodyTree.refit(body_centers.data(), body_radii.data());
+
+        visible_bodies.clear();
+        if (culling) {
+            BodyTree.cull(frustum, visible_bodies);
+        } else {
+            for (uint32_t i = 0; i < bodies.size(); i++) visible_bodies.push_back(i);
+        }
+        //
 
-        // Default Shader
-        DefaultShader.use();
-        DefaultShader.setMat4("view", view);
-        DefaultShader.setMat4("projection", projection);
+        // Orbits and bodies
+        visible_orbits = 0;
         for (unsigned int i = 0; i < planets.size() && Settings::get().showOrbit;
              i++) {
+            vec4 bounds = planets[i].orbitBounds();
+            if (culling && !frustum.intersects(vec3(bounds), bounds.w)) continue;
+
             planets[i].updateOrbitVertexData();
-            planets[i].drawOrbit(DefaultShader);
+            Planet *planet = &planets[i];
+            Queue.submit(DefaultShader, planet->orbitVertexArray(), opaque,
+                         length(vec3(bounds) - camera.Position),
+                         [&, planet] { planet->drawOrbit(DefaultShader); });
+            visible_orbits++;
         }
-        sun.render(DefaultShader);
+        if (Settings::get().showRotatingFrame)
+            Queue.submit(DefaultShader, 0, opaque, 0.0f,
+                         [&] { Frame.renderLagrangePoints(DefaultShader); });
+
+        Bodies.begin();
+        float spin_time = (float)Sim.snapshot().clock;
+        for (uint32_t i : visible_bodies) bodies[i]->submit(Bodies, spin_time);
+        for (size_t i = 0; i < extra_star_centers.size(); i++) {
+            vec3 center = extra_star_centers[i];
+            float radius = extra_star_radii[i];
+            if (culling && !frustum.intersects(center, radius)) continue;
+            BodyInstance star = {scale(translate(mat4(1.0f), center), vec3(radius)),
+                                 vec4(extra_star_colors[i], 1.0f), vec4(0.0f)};
+            Bodies.submit(center, radius, star);
+        }
+        if (Settings::get().showBelt) {
+            Belt.update(sun);
+            Belt.submit(Bodies);
+        }
+        Queue.submit(PlanetShader, 0, opaque, 0.0f, [&] {
+            Shadows.bind(PlanetShader);
+            Bodies.render();
+        });
+        Queue.submit(ImpostorShader, 0, opaque, 0.0f, [&] {
+            Shadows.bind(ImpostorShader);
+            Bodies.renderImpostors();
+        });
         //
 
-        // Draw Planet
-        PlanetShader.use();
-
-        PlanetShader.setMat4("view", view);
-        PlanetShader.setMat4("projection", projection);
-
-        PlanetShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-        PlanetShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
-        PlanetShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f);
-        PlanetShader.setFloat("material.shininess", 10.0f);
-
-        PlanetShader.setVec3("light.position", sun.position);
-        PlanetShader.setVec3("light.ambient", 0.0f, 0.0f, 0.0f);
-        PlanetShader.setVec3("light.diffuse", sun.color.r, sun.color.g, sun.color.b);
-        PlanetShader.setVec3("light.specular", 0.1f, 0.1f, 0.1f);
-
-        PlanetShader.setVec3("cameraPos", camera.Position);
-
-        for (unsigned int i = 0; i < planets.size(); i++) {
-            planets[i].render(PlanetShader);
+        // Gravity Well
+        if (Settings::get().showGravityWell) {
+            if (GravityWell.renderMode == GravityWell::RENDER_HEIGHTMAP)
+                Queue.submit(GravityWellMapShader, 0, blended, 0.0f, [&] {
+                    GravityWell.renderHeightMap(GravityWellMapShader);
+                });
+            else
+                Queue.submit(GravityWellShader, 0, blended, 0.0f,
+                             [&] { GravityWell.render(GravityWellShader); });
+            if (Settings::get().showContours)
+                Queue.submit(GravityWellShader, 0, blended, 0.0f, [&] {
+                    Contours.render(GravityWellShader, GravityWell.mapSize);
+                });
         }
+        if (Settings::get().showStreamlines)
+            Queue.submit(GravityWellShader, 0, blended, 0.0f, [&] {
+                FieldLines.render(GravityWellShader, GravityWell.mapSize);
+            });
         //
 
-        // Draw and Update Gravity Well
-        if (Settings::get().showGravityWell) {
-            GravityWellShader.use();
-            GravityWellShader.setMat4("view", view);
-            GravityWellShader.setMat4("projection", projection);
-            GravityWell.render(GravityWellShader, camera);
+        // Atmospheres dim what is behind them, so they come after everything
+        Air.begin();
+        if (Settings::get().showAtmosphere) {
+            for (const Planet &planet : planets) {
+                float outer = planet.boundingRadius() * Air.parameters().top;
+                if (culling && !frustum.intersects(planet.position, outer)) continue;
+                Air.add(planet.position, planet.boundingRadius());
+            }
+            Queue.submit(AtmosphereShader, 0, premultiplied, 0.0f, [&] {
+                Air.render(AtmosphereShader, sun.position, sun.color);
+            });
         }
+
+        // The sky is furthest back of the additive draws
+        if (Settings::get().showStarfield && Sky.loaded())
+            Queue.submit(StarfieldShader, 0, additive, 1.0e9f,
+                         [&] { Sky.render(StarfieldShader, 8.0f); });
+
+        // Sub-pixel bodies sort last, they only add light to what is behind them
+        Queue.submit(PointShader, 0, additive, 0.0f, [&] {
+            PointShader.set(point_limit, 8.0f);
+            PointShader.set(point_max_size, 2.0f * Bodies.impostorRadius);
+            Bodies.renderPoints(PointShader);
+        });
         //
 
+        Queue.flush();
+        // Upscale before the UI, which draws at native resolution
+        Resolution.end();
+
+        // Labels: the heaviest body of each screen cell, or the one followed
+        if (Settings::get().showLabels) {
+            Labels.begin(view, projection, camera.Position, io.DisplaySize.x,
+                         io.DisplaySize.y);
+            for (uint32_t i : visible_bodies) {
+                bool followed = bodies[i] == &planets[1];
+                Labels.add(bodies[i]->position,
+                           followed ? INFINITY : bodies[i]->mass,
+                           bodies[i]->name.c_str());
+            }
+            for (size_t i = 0; i < extra_star_centers.size(); i++)
+                Labels.add(extra_star_centers[i], extra_star_radii[i], "Star",
+                           static_cast<int>(i));
+            if (Settings::get().showBelt && Settings::get().labelAsteroids) {
+                // Only the asteroids the renderer kept and drew larger than a
+                // point: in view and near enough to be told apart. They are
+                // weighed by volume, far below any body's mass.
+                const vector<vec3> &positions = Belt.asteroidPositions();
+                const vector<float> &sizes = Belt.asteroidSizes();
+                for (uint32_t i : Bodies.resolvedSpheres())
+                    Labels.add(positions[i], -1.0f / (sizes[i] * sizes[i] * sizes[i]),
+                               "Asteroid", static_cast<int>(i));
+            }
+            Labels.draw(ImGui::GetForegroundDrawList());
+        }
+
         ImGui::Begin("Performance");
         ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
         ImGui::Text("Frame Time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+        ImGui::Text("Simulation: %.0f steps/s, %.3f ms/step, step %lu", Sim.stepRate(),
+                    Sim.stepTime(), Sim.snapshot().step);
+        ImGui::Checkbox("Dynamic Resolution", &Resolution.enabled);
+        ImGui::SliderFloat("GPU Budget (ms)", &Resolution.targetTime, 2.0f, 33.0f);
+        ImGui::SliderFloat("Min Scale", &Resolution.minScale, 0.25f, 1.0f);
+        ImGui::Text("Render Scale: %.0f%% (%dx%d), Scene GPU: %.2f ms",
+                    Resolution.scale() * 100.0f, Resolution.sceneWidth(),
+                    Resolution.sceneHeight(), Resolution.gpuTime());
+        ImGui::Text("Shader Startup: %.1f ms (%u cached, %u compiled, saved %.1f ms)",
+                    Programs.totalTime(), Programs.hitCount(), Programs.missCount(),
+                    Programs.savedTime());
+        ImGui::Text("Sky: %zu / %zu stars in %u draws", Sky.drawnCount(), Sky.size(),
+                    Sky.drawCallCount());
+        ImGui::Text("Lights: %zu, Cluster Entries: %zu, Busiest Cluster: %u",
+                    Lights.lightCount(), Lights.indexCount(), Lights.busiestCluster());
+        ImGui::Text("Atmospheres: %zu, tables %s in %.1f ms", Air.shellCount(),
+                    Air.fromCache() ? "loaded" : "built", Air.loadTime());
+        ImGui::Text("Shadow Lists: %zu, Occluder Candidates: %zu (of %zu)",
+                    Shadows.listCount(), Shadows.candidateCount(),
+                    Shadows.occluderCount());
+        ImGui::Text("Backend: %s", GLExt::directStateAccess()
+                                       ? "GL 4.5 (DSA, persistent buffers)"
+                                       : "GL 3.3 (orphaned buffers)");
+        ImGui::Text("Draw Items: %zu, State Changes: %u, Saved: %u", Queue.itemCount(),
+                    GLState::get().issuedCount(), GLState::get().skippedCount());
+        ImGui::Text("Body Draw Calls: %u (%zu bodies)", Bodies.drawCallCount(),
+                    Bodies.instanceCount());
+        ImGui::Text("Body Triangles: %zu, Impostors: %zu, Points: %zu",
+                    Bodies.triangleCount(), Bodies.impostorCount(),
+                    Bodies.pointCount());
+        ImGui::SliderFloat("Point Radius (px)", &Bodies.pointRadius, 0.0f, 8.0f);
+        ImGui::Checkbox("Frustum Culling", &Settings::get().frustumCulling);
+        ImGui::Text("Depth: %s", Settings::get().logarithmicDepth ? "logarithmic"
+                                                                  : "perspective");
+        ImGui::Text("Visible Bodies: %zu / %zu, Orbits: %u", visible_bodies.size(),
+                    bodies.size(), visible_orbits);
+        ImGui::Text("Culled Asteroids: %zu", Bodies.culledCount());
+        ImGui::SliderFloat("Impostor Radius (px)", &Bodies.impostorRadius, 0.0f, 64.0f);
+        ImGui::SliderFloat("LOD Pixel Error", &Bodies.pixelError, 0.1f, 8.0f, "%.2f",
+                           ImGuiSliderFlags_Logarithmic);
+        for (unsigned int lod = 0; lod < BodyRenderer::LOD_COUNT; lod++)
+            ImGui::Text("LOD %u (%u subdivisions): %zu", lod,
+                        BodyRenderer::lodSubdivisions(lod),
+                        Bodies.lodInstanceCount(lod));
         ImGui::End();
 
         // Rendering
         ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        if (!headless) ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         //
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        Capture.capture();
+        frame_count++;
+
+        if (!headless) {
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // Terminate, clearing all previously allocated GLFW resources.
+    Capture.close();
     ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if (!headless) ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-    glfwTerminate();
     return 0;
     //
 }
@@ -0,0 +1,39 @@
+#include "utils/FileCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace FileCache {
+
+uint64_t hash(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        seed ^= bytes[i];
+        seed *= 0x100000001b3ULL;
+    }
+    return seed;
+}
+
+bool write(const std::string& path, std::initializer_list<Chunk> chunks) {
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, error);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        for (const Chunk& chunk : chunks)
+            file.write(static_cast<const char*>(chunk.data),
+                       static_cast<std::streamsize>(chunk.size));
+        file.close();
+        if (!file) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+}  // namespace FileCache
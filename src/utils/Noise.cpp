@@ -0,0 +1,71 @@
+#include "utils/Noise.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace {
+
+float fade(float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); }
+
+float lerp(float a, float b, float t) { return a + t * (b - a); }
+
+// Dot product with one of the 12 cube edge gradients
+float gradient(uint8_t hash, float x, float y, float z) {
+    int h = hash & 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+}  // namespace
+
+PerlinNoise::PerlinNoise(uint32_t seed) {
+    uint8_t values[256];
+    std::iota(values, values + 256, 0);
+    std::shuffle(values, values + 256, std::mt19937(seed));
+    for (int i = 0; i < 512; i++) permutation[i] = values[i & 255];
+}
+
+float PerlinNoise::noise(float x, float y, float z) const {
+    float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+    int X = static_cast<int>(fx) & 255;
+    int Y = static_cast<int>(fy) & 255;
+    int Z = static_cast<int>(fz) & 255;
+    x -= fx;
+    y -= fy;
+    z -= fz;
+    float u = fade(x), v = fade(y), w = fade(z);
+
+    int A = permutation[X] + Y, AA = permutation[A] + Z, AB = permutation[A + 1] + Z;
+    int B = permutation[X + 1] + Y, BA = permutation[B] + Z,
+        BB = permutation[B + 1] + Z;
+
+    return lerp(
+        lerp(lerp(gradient(permutation[AA], x, y, z),
+                  gradient(permutation[BA], x - 1, y, z), u),
+             lerp(gradient(permutation[AB], x, y - 1, z),
+                  gradient(permutation[BB], x - 1, y - 1, z), u),
+             v),
+        lerp(lerp(gradient(permutation[AA + 1], x, y, z - 1),
+                  gradient(permutation[BA + 1], x - 1, y, z - 1), u),
+             lerp(gradient(permutation[AB + 1], x, y - 1, z - 1),
+                  gradient(permutation[BB + 1], x - 1, y - 1, z - 1), u),
+             v),
+        w);
+}
+
+float PerlinNoise::fbm(float x, float y, float z, int octaves, float lacunarity,
+                       float gain) const {
+    float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+    for (int i = 0; i < octaves; i++) {
+        sum += amplitude * noise(x, y, z);
+        total += amplitude;
+        amplitude *= gain;
+        x *= lacunarity;
+        y *= lacunarity;
+        z *= lacunarity;
+    }
+    return total > 0.0f ? sum / total : 0.0f;
+}
@@ -0,0 +1,68 @@
+#include "utils/ThreadPool.h"
+
+ThreadPool::ThreadPool() {
+    unsigned int hardware = std::thread::hardware_concurrency();
+    unsigned int workerCount = hardware > 1 ? hardware - 1 : 1;
+
+    for (unsigned int i = 0; i < workerCount; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+    if (count == 0) return;
+
+    std::lock_guard<std::mutex> dispatch(dispatchMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &job;
+        this->jobCount = count;
+        this->nextJob = 0;
+        this->busyWorkers = static_cast<unsigned int>(workers.size());
+        this->generation++;
+    }
+    wake.notify_all();
+
+    // The calling thread works too instead of idling until the workers finish
+    runJobs();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    this->job = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        runJobs();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) done.notify_one();
+    }
+}
+
+void ThreadPool::runJobs() {
+    while (true) {
+        size_t index = nextJob.fetch_add(1);
+        if (index >= jobCount) return;
+        (*job)(index);
+    }
+}